@@ -0,0 +1,43 @@
+# -----------------------------------------------------------------------------
+# @brief  : CMake functions of the namegen library.
+# @author : Enrico Fraccaroli
+# -----------------------------------------------------------------------------
+
+# Compiles pattern files into a header of C++14 generator functions, at build
+# time, with the namegen-patternc tool, and adds it to a target.
+#
+#   namegen_add_patterns(<target> <header>
+#       [NAMESPACE <namespace>]
+#       SOURCES <file>...)
+#
+# The header is written inside the binary directory, which is added to the
+# include directories of the target, so that sources can include it as
+# "<header>". The target is linked against the library.
+function(namegen_add_patterns target header)
+    cmake_parse_arguments(NAMEGEN "" "NAMESPACE" "SOURCES" ${ARGN})
+    if(NOT NAMEGEN_NAMESPACE)
+        set(NAMEGEN_NAMESPACE patterns)
+    endif()
+    if(NOT NAMEGEN_SOURCES)
+        message(FATAL_ERROR "namegen_add_patterns: no SOURCES given for ${header}")
+    endif()
+    # Take the sources relative to the calling directory.
+    set(sources)
+    foreach(source ${NAMEGEN_SOURCES})
+        get_filename_component(path ${source} ABSOLUTE)
+        list(APPEND sources ${path})
+    endforeach()
+    set(output ${CMAKE_CURRENT_BINARY_DIR}/${header})
+    get_filename_component(directory ${output} DIRECTORY)
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${directory}
+        COMMAND namegen-patternc -o ${output} -n ${NAMEGEN_NAMESPACE} ${sources}
+        DEPENDS namegen-patternc ${sources}
+        COMMENT "Generating pattern functions ${header}"
+        VERBATIM
+    )
+    target_sources(${target} PRIVATE ${output})
+    target_include_directories(${target} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+    target_link_libraries(${target} PRIVATE namegen::namegen)
+endfunction()
@@ -0,0 +1,23 @@
+#include "generated_patterns.hpp"
+
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+
+int main(int, char *[])
+{
+    uint64_t seed = static_cast<uint64_t>(time(NULL));
+    char name[patterns::elf_max_length + 1];
+
+    std::size_t length = patterns::elf(name, seed);
+
+    std::string orc, dwarf;
+    patterns::orc(orc, seed);
+    patterns::dwarf(dwarf, seed);
+
+    std::cout << "Elf     : " << name << " (" << length << " characters)\n";
+    std::cout << "Orc     : " << orc << "\n";
+    std::cout << "Dwarf   : " << dwarf << "\n";
+    std::cout << "Seed    : " << seed << "\n";
+    return 0;
+}
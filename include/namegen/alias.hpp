@@ -0,0 +1,99 @@
+/// @file alias.hpp
+/// @brief Alias tables, for weighted selection in constant time.
+/// @details
+/// Vose's alias method splits n weighted options into n columns of equal
+/// height, each holding at most two options. A single random number picks a
+/// column with its high bits and one of its two options with its low bits, so
+/// a selection costs one draw and one table lookup regardless of n.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace namegen
+{
+
+/// @brief A column of an alias table.
+struct alias_entry {
+    /// The column keeps its own option when the low bits are below this value.
+    uint32_t threshold;
+    /// The other option of the column.
+    uint32_t alias;
+};
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Returns the threshold of a column from the height of its option.
+/// @param height the height, which rounding errors can push slightly out of
+/// [0, 1).
+/// @return the threshold.
+inline uint32_t get_alias_threshold(double height)
+{
+    if (!(height > 0.)) {
+        return 0;
+    }
+    if (height >= 1.) {
+        return 0xffffffffU;
+    }
+    double scaled = height * 4294967296.0;
+    return (scaled < 4294967295.0) ? static_cast<uint32_t>(scaled) : 0xffffffffU;
+}
+
+/// @brief Builds the alias table of the given weights.
+/// @param table the table, with one entry per weight.
+/// @param weights the weights, if they are all zero the first option is
+/// always selected.
+inline void build_alias(std::vector<alias_entry> &table, const std::vector<double> &weights)
+{
+    std::size_t count = weights.size();
+    double total      = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        total += weights[i];
+    }
+    table.resize(count);
+    std::vector<double> height(count);
+    std::vector<uint32_t> small, large;
+    for (std::size_t i = 0; i < count; ++i) {
+        height[i] = (total > 0.) ? weights[i] * static_cast<double>(count) / total : (i == 0 ? static_cast<double>(count) : 0.);
+        (height[i] < 1. ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t less = small.back(), more = large.back();
+        small.pop_back();
+        table[less].threshold = get_alias_threshold(height[less]);
+        table[less].alias     = more;
+        height[more] -= 1. - height[less];
+        if (height[more] < 1.) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // Whatever is left is full, up to rounding errors.
+    for (std::size_t i = 0; i < large.size(); ++i) {
+        table[large[i]].threshold = 0xffffffffU;
+        table[large[i]].alias     = large[i];
+    }
+    for (std::size_t i = 0; i < small.size(); ++i) {
+        table[small[i]].threshold = 0xffffffffU;
+        table[small[i]].alias     = small[i];
+    }
+}
+
+/// @brief Selects an option with a single random number.
+/// @param table the alias table.
+/// @param count the number of options.
+/// @param random a random number between 0 and 0xffffffff.
+/// @return the selected option.
+inline std::size_t sample_alias(const alias_entry *table, std::size_t count, uint64_t random)
+{
+    uint64_t scaled    = (random & 0xffffffffUL) * count;
+    std::size_t column = static_cast<std::size_t>(scaled >> 32);
+    return ((scaled & 0xffffffffUL) < table[column].threshold) ? column : table[column].alias;
+}
+
+} // namespace detail
+
+} // namespace namegen
@@ -0,0 +1,106 @@
+/// @file arena.hpp
+/// @brief Batch generation of names into a contiguous arena.
+/// @details
+/// Generating names one std::string at a time costs an allocation per name.
+/// An arena stores a whole batch of names back to back inside a single
+/// buffer, each one followed by a zero, next to the offsets where they start.
+/// The compiled generator writes every name straight into the arena, so once
+/// the arena has grown to the size of a batch, refilling it allocates nothing.
+
+#pragma once
+
+#include "namegen/pattern.hpp"
+
+namespace namegen
+{
+
+/// @brief A batch of names stored back to back.
+class name_arena {
+public:
+    /// @brief Creates an empty arena.
+    name_arena()
+        : m_data(),
+          m_offsets(1, 0)
+    {
+    }
+
+    /// @brief Removes all the names, keeping the memory.
+    void clear()
+    {
+        m_data.clear();
+        m_offsets.assign(1, 0);
+    }
+
+    /// @brief Returns the number of names.
+    std::size_t size() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    /// @brief Returns true if the arena holds no names.
+    bool empty() const
+    {
+        return m_offsets.size() == 1;
+    }
+
+    /// @brief Returns the name at the given index, terminated by a zero.
+    const char *name(std::size_t index) const
+    {
+        return m_data.data() + m_offsets[index];
+    }
+
+    /// @brief Returns the length of the name at the given index.
+    std::size_t length(std::size_t index) const
+    {
+        return m_offsets[index + 1] - m_offsets[index] - 1;
+    }
+
+    /// @brief Returns the buffer holding all the names.
+    const std::string &data() const
+    {
+        return m_data;
+    }
+
+private:
+    friend return_code_t generate(name_arena &, const pattern &, std::size_t, uint64_t &);
+
+    /// The names, each one followed by a zero.
+    std::string m_data;
+    /// Where each name starts, followed by the end of the last one.
+    std::vector<std::size_t> m_offsets;
+};
+
+/// @brief Generate a batch of random names, appending them to an arena.
+/// @param arena the arena where the names are placed.
+/// @param compiled the compiled pattern.
+/// @param count the number of names to generate.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, or INVALID if the pattern was never compiled.
+inline return_code_t generate(name_arena &arena, const pattern &compiled, std::size_t count, uint64_t &seed)
+{
+    if (compiled.groups.empty()) {
+        return INVALID;
+    }
+    detail::null_recorder recorder;
+    arena.m_offsets.reserve(arena.m_offsets.size() + count);
+    for (std::size_t i = 0; i < count; ++i) {
+        // The name is written right after the previous one.
+        std::size_t location = arena.m_data.size();
+        if (compiled.engine == pattern::ENGINE_TABLE) {
+            std::size_t select = detail::select_output(compiled, seed);
+            arena.m_data.append(compiled.outputs.pool, compiled.outputs.offsets[select], compiled.outputs.lengths[select]);
+            location = arena.m_data.size();
+        } else if (compiled.engine == pattern::ENGINE_BYTECODE) {
+            location = detail::run_program(compiled, arena.m_data, location, seed);
+        } else {
+            bool capitalize = false;
+            detail::run_group(compiled, 0, arena.m_data, location, capitalize, seed, recorder);
+        }
+        arena.m_data.resize(location + 1);
+        arena.m_data[location] = 0;
+        arena.m_offsets.push_back(location + 1);
+    }
+    return SUCCESS;
+}
+
+} // namespace namegen
@@ -0,0 +1,472 @@
+/// @file automaton.hpp
+/// @brief Patterns seen as automata over bytes.
+/// @details
+/// A compiled pattern describes a finite language, where every name comes with
+/// the probability generate() gives it. The automaton class spells that
+/// language out byte by byte: a weighted, acyclic, nondeterministic automaton
+/// whose paths are the derivations of the pattern, and whose path weights are
+/// their probabilities. Capitalization is resolved while building it, hence
+/// "!s" only accepts capitalized syllables.
+///
+/// The dfa class is a plain deterministic automaton over bytes, used to
+/// express constraints on the generated names.
+
+#pragma once
+
+#include "namegen/pattern.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// Marks a missing state.
+const uint32_t no_state = 0xffffffffU;
+
+} // namespace detail
+
+/// @brief A weighted acyclic automaton spelling out the outputs of a pattern.
+/// @details Edges always lead from a state to one with a greater index, hence
+/// the index order is a topological order. Every state leads to the final one,
+/// and the weights of the edges leaving a state sum up to one.
+class automaton {
+public:
+    /// Symbol of the edges which consume no byte.
+    enum { epsilon = -1 };
+
+    /// @brief A transition between two states.
+    struct edge {
+        /// The state the edge leads to.
+        uint32_t target;
+        /// The byte consumed, or epsilon.
+        int symbol;
+        /// The probability of taking the edge.
+        double weight;
+    };
+
+    /// @brief Spells out the given pattern.
+    /// @param compiled the compiled pattern, which must not be empty.
+    explicit automaton(const pattern &compiled)
+        : m_final(0)
+    {
+        m_pending.push_back(std::vector<edge>());
+        lanes entry;
+        entry.state[0] = 0;
+        entry.state[1] = detail::no_state;
+        lanes exit     = this->build_group(compiled, 0, entry);
+        m_final        = this->join(exit.state[0], exit.state[1]);
+        // Flatten the edges.
+        m_first.push_back(0);
+        for (std::size_t s = 0; s < m_pending.size(); ++s) {
+            m_edges.insert(m_edges.end(), m_pending[s].begin(), m_pending[s].end());
+            m_first.push_back(static_cast<uint32_t>(m_edges.size()));
+        }
+        m_pending.clear();
+    }
+
+    /// @brief Returns the number of states.
+    std::size_t size() const
+    {
+        return m_first.size() - 1;
+    }
+
+    /// @brief Returns the initial state.
+    uint32_t start() const
+    {
+        return 0;
+    }
+
+    /// @brief Returns the final state, the only accepting one.
+    uint32_t final_state() const
+    {
+        return m_final;
+    }
+
+    /// @brief Returns the first edge leaving the given state.
+    const edge *begin(uint32_t state) const
+    {
+        return m_edges.data() + m_first[state];
+    }
+
+    /// @brief Returns the end of the edges leaving the given state.
+    const edge *end(uint32_t state) const
+    {
+        return m_edges.data() + m_first[state + 1];
+    }
+
+private:
+    /// @brief The states reached with the capitalization flag clear (0) and
+    /// set (1), or no_state if the flag cannot have that value.
+    struct lanes {
+        uint32_t state[2];
+    };
+
+    /// @brief Creates a new state.
+    uint32_t add_state()
+    {
+        m_pending.push_back(std::vector<edge>());
+        return static_cast<uint32_t>(m_pending.size() - 1);
+    }
+
+    /// @brief Adds an edge.
+    void add_edge(uint32_t source, uint32_t target, int symbol, double weight)
+    {
+        edge e;
+        e.target = target;
+        e.symbol = symbol;
+        e.weight = weight;
+        m_pending[source].push_back(e);
+    }
+
+    /// @brief Merges two states into one, either can be no_state.
+    uint32_t join(uint32_t lhs, uint32_t rhs)
+    {
+        if ((lhs == detail::no_state) || (rhs == detail::no_state)) {
+            return (lhs == detail::no_state) ? rhs : lhs;
+        }
+        uint32_t state = this->add_state();
+        this->add_edge(lhs, state, epsilon, 1.);
+        this->add_edge(rhs, state, epsilon, 1.);
+        return state;
+    }
+
+    /// @brief Merges several states into one.
+    uint32_t join(const std::vector<uint32_t> &sources)
+    {
+        if (sources.size() < 2) {
+            return sources.empty() ? detail::no_state : sources[0];
+        }
+        uint32_t state = this->add_state();
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            this->add_edge(sources[i], state, epsilon, 1.);
+        }
+        return state;
+    }
+
+    /// @brief Spells out a group.
+    lanes build_group(const pattern &compiled, std::size_t index, lanes entry)
+    {
+        const pattern::group &group = compiled.groups[index];
+        std::vector<uint32_t> sources[2];
+        for (std::size_t a = group.first; a < group.last; ++a) {
+            const pattern::alternative &alternative = compiled.alternatives[a];
+            // Every alternative is entered with the flag of the group.
+            lanes inside = entry;
+            if ((group.last - group.first) > 1) {
+                for (int f = 0; f < 2; ++f) {
+                    if (entry.state[f] != detail::no_state) {
+                        inside.state[f] = this->add_state();
+                        this->add_edge(entry.state[f], inside.state[f], epsilon, alternative.probability);
+                    }
+                }
+            }
+            for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+                inside = this->build_item(compiled, compiled.items[i], inside);
+            }
+            // The skipped alternatives that follow can still change the flag.
+            for (int f = 0; f < 2; ++f) {
+                if (inside.state[f] != detail::no_state) {
+                    sources[detail::apply_effect(alternative.tail, f != 0)].push_back(inside.state[f]);
+                }
+            }
+        }
+        lanes exit;
+        exit.state[0] = this->join(sources[0]);
+        exit.state[1] = this->join(sources[1]);
+        return exit;
+    }
+
+    /// @brief Spells out an item.
+    lanes build_item(const pattern &compiled, const pattern::item &item, lanes entry)
+    {
+        lanes exit;
+        exit.state[0] = exit.state[1] = detail::no_state;
+        if (item.kind == pattern::ITEM_CAPITALIZE) {
+            exit.state[1] = this->join(entry.state[0], entry.state[1]);
+        } else if (item.kind == pattern::ITEM_GROUP) {
+            exit = this->build_group(compiled, item.group, entry);
+        } else if (item.kind == pattern::ITEM_LITERAL) {
+            exit.state[0] = this->add_state();
+            for (int f = 0; f < 2; ++f) {
+                if (entry.state[f] != detail::no_state) {
+                    this->add_edge(entry.state[f], exit.state[0], static_cast<unsigned char>(detail::get_capitalized(item.value, f != 0)), 1.);
+                }
+            }
+        } else {
+            // The states after the first character are shared by both lanes,
+            // the target state must be created after all of them.
+            const token_table &table = *item.table;
+            std::vector<uint32_t> second(table.size(), detail::no_state);
+            std::vector<uint32_t> third(table.size(), detail::no_state);
+            std::vector<uint32_t> last(table.size(), detail::no_state);
+            // The first two bytes of the capitalized tokens, and the state
+            // between them when capitalization changes both, as it does for
+            // letters encoded with two bytes in UTF-8.
+            std::vector<char> upper(2 * table.size());
+            std::vector<uint32_t> middle(table.size(), detail::no_state);
+            for (std::size_t k = 0; k < table.size(); ++k) {
+                const char *token = table.token(k);
+                std::size_t size  = std::min<std::size_t>(table.length(k), 2);
+                std::copy(token, token + size, upper.begin() + static_cast<std::ptrdiff_t>(2 * k));
+                detail::capitalize_token(&upper[2 * k], size);
+                if ((entry.state[1] != detail::no_state) && (size == 2) && (upper[2 * k + 1] != token[1])) {
+                    middle[k] = this->add_state();
+                }
+                for (std::size_t i = 1; token[i]; ++i) {
+                    uint32_t state = this->add_state();
+                    if (i == 1) {
+                        second[k] = state;
+                    } else {
+                        this->add_edge(last[k], state, static_cast<unsigned char>(token[i - 1]), 1.);
+                    }
+                    if (i == 2) {
+                        third[k] = state;
+                    }
+                    last[k] = state;
+                }
+            }
+            exit.state[0] = this->add_state();
+            for (std::size_t k = 0; k < table.size(); ++k) {
+                const char *token = table.token(k);
+                double weight     = detail::token_probability(item, k);
+                uint32_t first    = (second[k] == detail::no_state) ? exit.state[0] : second[k];
+                for (int f = 0; f < 2; ++f) {
+                    if (entry.state[f] == detail::no_state) {
+                        continue;
+                    }
+                    if (table.length(k) == 0) {
+                        // An empty token only clears the flag.
+                        this->add_edge(entry.state[f], exit.state[0], epsilon, weight);
+                    } else if (f && (middle[k] != detail::no_state)) {
+                        uint32_t after = (third[k] == detail::no_state) ? exit.state[0] : third[k];
+                        this->add_edge(entry.state[f], middle[k], static_cast<unsigned char>(upper[2 * k]), weight);
+                        this->add_edge(middle[k], after, static_cast<unsigned char>(upper[2 * k + 1]), 1.);
+                    } else {
+                        this->add_edge(entry.state[f], first, static_cast<unsigned char>(f ? upper[2 * k] : token[0]), weight);
+                    }
+                }
+                if (last[k] != detail::no_state) {
+                    this->add_edge(last[k], exit.state[0], static_cast<unsigned char>(token[table.length(k) - 1]), 1.);
+                }
+            }
+        }
+        return exit;
+    }
+
+    /// The final state.
+    uint32_t m_final;
+    /// The edges of each state, while building.
+    std::vector<std::vector<edge> > m_pending;
+    /// The edges, sorted by source state.
+    std::vector<edge> m_edges;
+    /// The first edge of each state.
+    std::vector<uint32_t> m_first;
+};
+
+/// @brief A deterministic automaton over bytes.
+/// @details Bytes which every state treats the same way share a class, and the
+/// transition table only has one column per class. State 0 is the initial one.
+class dfa {
+public:
+    /// @brief Creates an automaton that accepts everything.
+    dfa()
+        : m_classes(1),
+          m_table(1, 0),
+          m_accepting(1, true),
+          m_live(1, true)
+    {
+        std::fill(m_class, m_class + 256, static_cast<uint16_t>(0));
+    }
+
+    /// @brief Creates an automaton from its full transition table.
+    /// @param table for each state, the 256 states reached on each byte.
+    /// @param accepting which states are accepting.
+    dfa(const std::vector<uint32_t> &table, const std::vector<bool> &accepting)
+        : m_classes(0),
+          m_accepting(accepting)
+    {
+        std::size_t states = accepting.size();
+        // Group together the bytes with identical columns.
+        std::map<std::vector<uint32_t>, uint16_t> columns;
+        std::vector<uint32_t> column(states);
+        for (std::size_t c = 0; c < 256; ++c) {
+            for (std::size_t s = 0; s < states; ++s) {
+                column[s] = table[s * 256 + c];
+            }
+            std::map<std::vector<uint32_t>, uint16_t>::iterator it = columns.find(column);
+            if (it == columns.end()) {
+                it = columns.insert(std::make_pair(column, static_cast<uint16_t>(m_classes++))).first;
+            }
+            m_class[c] = it->second;
+        }
+        m_table.resize(states * m_classes);
+        for (std::size_t c = 0; c < 256; ++c) {
+            for (std::size_t s = 0; s < states; ++s) {
+                m_table[s * m_classes + m_class[c]] = table[s * 256 + c];
+            }
+        }
+        // A state is live if it can still reach an accepting one.
+        m_live = m_accepting;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t s = 0; s < states; ++s) {
+                for (std::size_t k = 0; (k < m_classes) && !m_live[s]; ++k) {
+                    if (m_live[m_table[s * m_classes + k]]) {
+                        m_live[s] = changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    /// @brief Returns the number of states.
+    std::size_t size() const
+    {
+        return m_accepting.size();
+    }
+
+    /// @brief Returns the number of byte classes.
+    std::size_t classes() const
+    {
+        return m_classes;
+    }
+
+    /// @brief Returns the class of the given byte.
+    std::size_t byte_class(unsigned char c) const
+    {
+        return m_class[c];
+    }
+
+    /// @brief Returns the initial state.
+    uint32_t start() const
+    {
+        return 0;
+    }
+
+    /// @brief Returns the state reached from state on byte c.
+    uint32_t next(uint32_t state, unsigned char c) const
+    {
+        return m_table[state * m_classes + m_class[c]];
+    }
+
+    /// @brief Returns true if the state is accepting.
+    bool accepting(uint32_t state) const
+    {
+        return m_accepting[state];
+    }
+
+    /// @brief Returns true if an accepting state can still be reached.
+    bool live(uint32_t state) const
+    {
+        return m_live[state];
+    }
+
+    /// @brief Returns true if the automaton accepts the string.
+    bool matches(const std::string &s) const
+    {
+        return this->matches(s.data(), s.size());
+    }
+
+    /// @brief Returns true if the automaton accepts the given characters.
+    /// @param s the characters, which need not be terminated by a zero.
+    /// @param length the number of characters.
+    bool matches(const char *s, std::size_t length) const
+    {
+        uint32_t state = this->start();
+        for (std::size_t i = 0; (i < length) && m_live[state]; ++i) {
+            state = this->next(state, static_cast<unsigned char>(s[i]));
+        }
+        return m_accepting[state];
+    }
+
+private:
+    /// The class of each byte.
+    uint16_t m_class[256];
+    /// The number of classes.
+    std::size_t m_classes;
+    /// The transitions, one row per state and one column per class.
+    std::vector<uint32_t> m_table;
+    /// The accepting states.
+    std::vector<bool> m_accepting;
+    /// The states that can still reach an accepting one.
+    std::vector<bool> m_live;
+};
+
+/// @brief Builds the automaton accepting the strings that start with a prefix.
+/// @param prefix the prefix.
+/// @return the automaton.
+inline dfa prefix_constraint(const std::string &prefix)
+{
+    // State i has matched i characters, the last one is the dead state.
+    uint32_t size = static_cast<uint32_t>(prefix.size());
+    std::vector<uint32_t> table((size + 2) * 256, size + 1);
+    std::vector<bool> accepting(size + 2, false);
+    for (uint32_t i = 0; i < size; ++i) {
+        table[i * 256 + static_cast<unsigned char>(prefix[i])] = i + 1;
+    }
+    std::fill(table.begin() + size * 256, table.begin() + (size + 1) * 256, size);
+    accepting[size] = true;
+    return dfa(table, accepting);
+}
+
+/// @brief Builds the automaton accepting the strings that end with a suffix.
+/// @param suffix the suffix.
+/// @return the automaton.
+inline dfa suffix_constraint(const std::string &suffix)
+{
+    // State i is the length of the longest prefix of the suffix which is also
+    // a suffix of the input (Knuth-Morris-Pratt).
+    uint32_t size = static_cast<uint32_t>(suffix.size());
+    std::vector<uint32_t> table((size + 1) * 256, 0);
+    std::vector<bool> accepting(size + 1, false);
+    uint32_t fallback = 0;
+    for (uint32_t i = 0; i <= size; ++i) {
+        for (std::size_t c = 0; c < 256; ++c) {
+            table[i * 256 + c] = table[fallback * 256 + c];
+        }
+        if (i < size) {
+            unsigned char c = static_cast<unsigned char>(suffix[i]);
+            if (i > 0) {
+                fallback = table[fallback * 256 + c];
+            }
+            table[i * 256 + c] = i + 1;
+        }
+    }
+    accepting[size] = true;
+    return dfa(table, accepting);
+}
+
+/// @brief Builds the automaton accepting the strings accepted by both.
+/// @param lhs the first automaton.
+/// @param rhs the second automaton.
+/// @return the product automaton, restricted to its reachable states.
+inline dfa intersect(const dfa &lhs, const dfa &rhs)
+{
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> index;
+    std::vector<std::pair<uint32_t, uint32_t> > states;
+    std::vector<uint32_t> table;
+    std::vector<bool> accepting;
+    states.push_back(std::make_pair(lhs.start(), rhs.start()));
+    index[states.back()] = 0;
+    for (std::size_t s = 0; s < states.size(); ++s) {
+        std::pair<uint32_t, uint32_t> state = states[s];
+        accepting.push_back(lhs.accepting(state.first) && rhs.accepting(state.second));
+        for (std::size_t c = 0; c < 256; ++c) {
+            std::pair<uint32_t, uint32_t> next(lhs.next(state.first, static_cast<unsigned char>(c)), rhs.next(state.second, static_cast<unsigned char>(c)));
+            std::map<std::pair<uint32_t, uint32_t>, uint32_t>::iterator it = index.find(next);
+            if (it == index.end()) {
+                it = index.insert(std::make_pair(next, static_cast<uint32_t>(states.size()))).first;
+                states.push_back(next);
+            }
+            table.push_back(it->second);
+        }
+    }
+    return dfa(table, accepting);
+}
+
+} // namespace namegen
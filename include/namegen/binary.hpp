@@ -0,0 +1,380 @@
+/// @file binary.hpp
+/// @brief Binary dictionary files, loaded without parsing.
+/// @details
+/// A dictionary file stores every table in the same packed layout the
+/// token_table class uses in memory: the pool of tokens, the arrays of offsets,
+/// lengths and weights, and the alias table of weighted tables. A header
+/// indexes the tables by key, and a sorted array indexes them by name.
+///
+/// Loading a file maps it in memory, checks its structure, and creates token
+/// tables that view the mapped arrays, so the cost does not depend on the
+/// number of tokens, and processes that load the same file share the same
+/// pages. The structure of the file is checked, and so is every index into
+/// the pool or the table of a token, hence a corrupted file is rejected
+/// instead of reading out of bounds; the weights are trusted.
+/// Files use the byte order of the machine that wrote them, and files with a
+/// different byte order are rejected.
+
+#pragma once
+
+#include "namegen/dictionary.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Version of the binary dictionary format.
+#define NAME_DICTIONARY_VERSION 1
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief The header of a dictionary file.
+struct file_header {
+    /// The characters "NAMEGDIC".
+    char magic[8];
+    /// The version of the format.
+    uint32_t version;
+    /// The value 0x01020304, in the byte order of the file.
+    uint32_t byte_order;
+    /// The size of the whole file.
+    uint64_t size;
+    /// The number of tables.
+    uint32_t tables;
+    /// The number of names.
+    uint32_t names;
+    /// Where the array of file_table starts.
+    uint64_t table_offset;
+    /// Where the array of file_name starts.
+    uint64_t name_offset;
+    /// The index of the table of each key, 0xffffffff if none.
+    uint32_t keys[256];
+};
+
+/// @brief Where the arrays of a table are stored, as offsets from the start of
+/// the file.
+struct file_table {
+    /// The pool of tokens.
+    uint64_t pool;
+    /// The size of the pool.
+    uint64_t pool_size;
+    /// The offsets of the tokens inside the pool.
+    uint64_t offsets;
+    /// The lengths of the tokens.
+    uint64_t lengths;
+    /// The weights of the tokens.
+    uint64_t weights;
+    /// The alias table, 0 if all the tokens weigh the same.
+    uint64_t alias;
+    /// The sum of the weights.
+    uint64_t total;
+    /// The number of tokens.
+    uint64_t size;
+};
+
+/// @brief A name bound to a table.
+struct file_name {
+    /// Where the characters of the name are stored.
+    uint64_t offset;
+    /// The length of the name.
+    uint32_t length;
+    /// The index of the table.
+    uint32_t table;
+};
+
+/// @brief Appends raw bytes to the image of a file, aligned to 8 bytes.
+/// @param image the image of the file.
+/// @param data the bytes.
+/// @param size the number of bytes.
+/// @return where the bytes start.
+inline uint64_t append_aligned(std::string &image, const void *data, std::size_t size)
+{
+    image.resize((image.size() + 7) & ~static_cast<std::size_t>(7), 0);
+    uint64_t offset = image.size();
+    if (size) {
+        image.append(static_cast<const char *>(data), size);
+    }
+    return offset;
+}
+
+/// @brief Builds the image of the file of a dictionary.
+/// @param image the image, it is overwritten.
+/// @param tables the dictionary.
+inline void serialize(std::string &image, const dictionary &tables)
+{
+    std::vector<unsigned char> keys = tables.keys();
+    std::vector<std::string> names  = tables.names();
+    // Every distinct table is written once.
+    std::vector<const token_table *> order;
+    std::map<const token_table *, uint32_t> index;
+    file_header header;
+    std::memset(&header, 0, sizeof(header));
+    for (std::size_t i = 0; i < 256; ++i) {
+        header.keys[i] = 0xffffffffU;
+    }
+    for (std::size_t i = 0; i < keys.size() + names.size(); ++i) {
+        const token_table *table = (i < keys.size()) ? tables.find(keys[i]) : tables.find(names[i - keys.size()]);
+        if (index.insert(std::make_pair(table, static_cast<uint32_t>(order.size()))).second) {
+            order.push_back(table);
+        }
+        if (i < keys.size()) {
+            header.keys[keys[i]] = index[table];
+        }
+    }
+    std::memcpy(header.magic, "NAMEGDIC", 8);
+    header.version    = NAME_DICTIONARY_VERSION;
+    header.byte_order = 0x01020304U;
+    header.tables     = static_cast<uint32_t>(order.size());
+    header.names      = static_cast<uint32_t>(names.size());
+
+    image.assign(sizeof(file_header), 0);
+    std::vector<file_table> entries(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        const token_table::layout &arrays = order[i]->arrays();
+        entries[i].size                   = arrays.size;
+        entries[i].total                  = arrays.total;
+        entries[i].pool_size              = arrays.pool_size;
+        entries[i].pool                   = append_aligned(image, arrays.pool, arrays.pool_size);
+        entries[i].offsets                = append_aligned(image, arrays.offsets, arrays.size * sizeof(uint32_t));
+        entries[i].lengths                = append_aligned(image, arrays.lengths, arrays.size * sizeof(uint32_t));
+        entries[i].weights                = append_aligned(image, arrays.weights, arrays.size * sizeof(uint32_t));
+        entries[i].alias                  = arrays.alias ? append_aligned(image, arrays.alias, arrays.size * sizeof(alias_entry)) : 0;
+    }
+    std::vector<file_name> bindings(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        bindings[i].offset = append_aligned(image, names[i].data(), names[i].size());
+        bindings[i].length = static_cast<uint32_t>(names[i].size());
+        bindings[i].table  = index[tables.find(names[i])];
+    }
+    header.table_offset = entries.empty() ? 0 : append_aligned(image, &entries[0], entries.size() * sizeof(file_table));
+    header.name_offset  = bindings.empty() ? 0 : append_aligned(image, &bindings[0], bindings.size() * sizeof(file_name));
+    image.resize((image.size() + 7) & ~static_cast<std::size_t>(7), 0);
+    header.size = image.size();
+    std::memcpy(&image[0], &header, sizeof(header));
+}
+
+/// @brief Checks that a range of bytes lies inside the file.
+/// @param offset where the range starts.
+/// @param size the size of the range.
+/// @param alignment the alignment the range requires.
+/// @param limit the size of the file.
+/// @return true if the range is valid.
+inline bool check_range(uint64_t offset, uint64_t size, uint64_t alignment, uint64_t limit)
+{
+    return (offset % alignment == 0) && (offset <= limit) && (size <= limit - offset);
+}
+
+/// @brief Checks that the arrays of a table index inside it.
+/// @param base the start of the image.
+/// @param entry the table, whose ranges are already checked.
+/// @return true if every token lies inside the pool, followed by its zero,
+/// and every alias is a token of the table.
+inline bool check_table(const char *base, const file_table &entry)
+{
+    const char *pool         = base + entry.pool;
+    const uint32_t *offsets  = reinterpret_cast<const uint32_t *>(base + entry.offsets);
+    const uint32_t *lengths  = reinterpret_cast<const uint32_t *>(base + entry.lengths);
+    const alias_entry *alias = entry.alias ? reinterpret_cast<const alias_entry *>(base + entry.alias) : NULL;
+    for (uint64_t i = 0; i < entry.size; ++i) {
+        uint64_t end = static_cast<uint64_t>(offsets[i]) + lengths[i];
+        if ((end >= entry.pool_size) || (pool[end] != 0) || (alias && (alias[i].alias >= entry.size))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief A file mapped in memory, or read into it where mapping is not
+/// available.
+class mapped_file {
+public:
+    /// @brief Maps the given file.
+    explicit mapped_file(const std::string &path)
+        : m_data(NULL),
+          m_size(0),
+          m_copy()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if ((::fstat(fd, &info) == 0) && (info.st_size > 0)) {
+            void *data = ::mmap(NULL, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = data;
+                m_size = static_cast<std::size_t>(info.st_size);
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+        if (!file) {
+            return;
+        }
+        std::streamoff size = file.tellg();
+        if (size <= 0) {
+            return;
+        }
+        // Words keep the arrays aligned.
+        m_copy.resize((static_cast<std::size_t>(size) + 7) / 8);
+        file.seekg(0);
+        if (file.read(reinterpret_cast<char *>(&m_copy[0]), size)) {
+            m_data = &m_copy[0];
+            m_size = static_cast<std::size_t>(size);
+        }
+#endif
+    }
+
+    /// @brief Unmaps the file.
+    ~mapped_file()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (m_data) {
+            ::munmap(m_data, m_size);
+        }
+#endif
+    }
+
+    /// @brief Returns the content of the file, NULL if it could not be read.
+    const void *data() const
+    {
+        return m_data;
+    }
+
+    /// @brief Returns the size of the file.
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    mapped_file(const mapped_file &);
+    mapped_file &operator=(const mapped_file &);
+
+    /// The content of the file.
+    void *m_data;
+    /// The size of the file.
+    std::size_t m_size;
+    /// The content of the file, when it is read instead of mapped.
+    std::vector<uint64_t> m_copy;
+};
+
+} // namespace detail
+
+/// @brief Writes a dictionary into a binary file.
+/// @param tables the dictionary, only its user tables are written.
+/// @param path the path of the file.
+/// @return false if the file could not be written.
+inline bool save(const dictionary &tables, const std::string &path)
+{
+    std::string image;
+    detail::serialize(image, tables);
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    return file.write(image.data(), static_cast<std::streamsize>(image.size())) && file.flush();
+}
+
+/// @brief Adds the tables stored in a binary image to a dictionary, without
+/// copying them.
+/// @param tables the dictionary, the tables of the image replace the ones
+/// bound to the same keys and names.
+/// @param data the image, aligned to 8 bytes, which must outlive the
+/// dictionary, unless it is kept alive through dictionary::retain().
+/// @param size the size of the image.
+/// @return false if the image is not a valid dictionary, in which case the
+/// dictionary is left untouched.
+inline bool load(dictionary &tables, const void *data, std::size_t size)
+{
+    const char *base = static_cast<const char *>(data);
+    detail::file_header header;
+    if (!base || (size < sizeof(header)) || (reinterpret_cast<uintptr_t>(base) % 8 != 0)) {
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if ((std::memcmp(header.magic, "NAMEGDIC", 8) != 0) ||
+        (header.version != NAME_DICTIONARY_VERSION) ||
+        (header.byte_order != 0x01020304U) ||
+        (header.size != size) ||
+        !detail::check_range(header.table_offset, static_cast<uint64_t>(header.tables) * sizeof(detail::file_table), 8, size) ||
+        !detail::check_range(header.name_offset, static_cast<uint64_t>(header.names) * sizeof(detail::file_name), 8, size)) {
+        return false;
+    }
+    const detail::file_table *entries = reinterpret_cast<const detail::file_table *>(base + header.table_offset);
+    const detail::file_name *bindings = reinterpret_cast<const detail::file_name *>(base + header.name_offset);
+    std::vector<token_table> views(header.tables);
+    for (std::size_t i = 0; i < header.tables; ++i) {
+        const detail::file_table &entry = entries[i];
+        uint64_t words                  = entry.size * sizeof(uint32_t);
+        if ((entry.size > 0xffffffffU) ||
+            !detail::check_range(entry.pool, entry.pool_size, 1, size) ||
+            ((entry.size > 0) && ((entry.pool_size == 0) || (base[entry.pool + entry.pool_size - 1] != 0))) ||
+            !detail::check_range(entry.offsets, words, 4, size) ||
+            !detail::check_range(entry.lengths, words, 4, size) ||
+            !detail::check_range(entry.weights, words, 4, size) ||
+            (entry.alias && !detail::check_range(entry.alias, entry.size * sizeof(alias_entry), 4, size)) ||
+            !detail::check_table(base, entry)) {
+            return false;
+        }
+        token_table::layout arrays;
+        arrays.pool      = base + entry.pool;
+        arrays.offsets   = reinterpret_cast<const uint32_t *>(base + entry.offsets);
+        arrays.lengths   = reinterpret_cast<const uint32_t *>(base + entry.lengths);
+        arrays.weights   = reinterpret_cast<const uint32_t *>(base + entry.weights);
+        arrays.alias     = entry.alias ? reinterpret_cast<const alias_entry *>(base + entry.alias) : NULL;
+        arrays.size      = static_cast<std::size_t>(entry.size);
+        arrays.pool_size = static_cast<std::size_t>(entry.pool_size);
+        arrays.total     = entry.total;
+        views[i]         = token_table::view(arrays);
+    }
+    for (std::size_t i = 0; i < header.names; ++i) {
+        if (!detail::check_range(bindings[i].offset, bindings[i].length, 1, size) || (bindings[i].table >= header.tables)) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < 256; ++i) {
+        if ((header.keys[i] != 0xffffffffU) && (header.keys[i] >= header.tables)) {
+            return false;
+        }
+    }
+    // The image is valid, bind its tables.
+    for (std::size_t i = 0; i < 256; ++i) {
+        if (header.keys[i] != 0xffffffffU) {
+            tables.insert(static_cast<unsigned char>(i), views[header.keys[i]]);
+        }
+    }
+    for (std::size_t i = 0; i < header.names; ++i) {
+        tables.insert(std::string(base + bindings[i].offset, bindings[i].length), views[bindings[i].table]);
+    }
+    return true;
+}
+
+/// @brief Adds the tables stored in a binary file to a dictionary. The file
+/// is mapped in memory, and stays mapped as long as the dictionary, or any of
+/// its copies, exists.
+/// @param tables the dictionary, the tables of the file replace the ones bound
+/// to the same keys and names.
+/// @param path the path of the file.
+/// @return false if the file cannot be read or is not a valid dictionary, in
+/// which case the dictionary is left untouched.
+inline bool load(dictionary &tables, const std::string &path)
+{
+    std::shared_ptr<detail::mapped_file> file = std::make_shared<detail::mapped_file>(path);
+    if (!load(tables, file->data(), file->size())) {
+        return false;
+    }
+    tables.retain(file);
+    return true;
+}
+
+} // namespace namegen
@@ -0,0 +1,156 @@
+/// @file blocklist.hpp
+/// @brief Filtering of banned substrings from generated names.
+/// @details
+/// The blocklist compiles the banned words into an Aho-Corasick automaton over
+/// bytes, turned into a dfa that rejects every string containing one of them.
+/// Intersected with the automaton of a pattern through a constrained_sampler,
+/// it makes banned names unreachable, so nothing is generated and thrown away.
+///
+/// When intersecting is not worth it (e.g., a pattern used only a handful of
+/// times), the same automaton checks a generated name in a single pass, and
+/// stops at the first banned word.
+
+#pragma once
+
+#include "namegen/constraint.hpp"
+
+#include <deque>
+
+namespace namegen
+{
+
+/// @brief A set of banned substrings.
+class blocklist {
+public:
+    /// @brief Compiles the banned words.
+    /// @param words the banned words, empty ones are ignored.
+    /// @param ignore_case if ASCII letters match regardless of their case.
+    explicit blocklist(const std::vector<std::string> &words, bool ignore_case = true)
+    {
+        // Build the trie, node 0 is the root.
+        std::vector<uint32_t> table(256, 0);
+        std::vector<bool> banned(1, false);
+        for (std::size_t w = 0; w < words.size(); ++w) {
+            if (words[w].empty()) {
+                continue;
+            }
+            uint32_t node = 0;
+            for (std::size_t i = 0; i < words[w].size(); ++i) {
+                unsigned char c = fold(words[w][i], ignore_case);
+                if (table[node * 256 + c] == 0) {
+                    table[node * 256 + c] = static_cast<uint32_t>(banned.size());
+                    table.resize(table.size() + 256, 0);
+                    banned.push_back(false);
+                }
+                node = table[node * 256 + c];
+            }
+            banned[node] = true;
+        }
+        // Complete the transitions along the failure links, breadth first.
+        std::vector<uint32_t> failure(banned.size(), 0);
+        std::deque<uint32_t> queue;
+        for (std::size_t c = 0; c < 256; ++c) {
+            if (table[c] != 0) {
+                queue.push_back(table[c]);
+            }
+        }
+        while (!queue.empty()) {
+            uint32_t node = queue.front();
+            queue.pop_front();
+            banned[node] = banned[node] || banned[failure[node]];
+            for (std::size_t c = 0; c < 256; ++c) {
+                uint32_t &next = table[node * 256 + c];
+                if (next == 0) {
+                    next = table[failure[node] * 256 + c];
+                } else {
+                    failure[next] = table[failure[node] * 256 + c];
+                    queue.push_back(next);
+                }
+            }
+        }
+        // Once a banned word is found the outcome cannot change anymore, so
+        // every banned node becomes a trap.
+        for (std::size_t node = 0; node < banned.size(); ++node) {
+            for (std::size_t c = 0; c < 256; ++c) {
+                if (banned[node]) {
+                    table[node * 256 + c] = static_cast<uint32_t>(node);
+                } else if (ignore_case && (c >= 'A') && (c <= 'Z')) {
+                    table[node * 256 + c] = table[node * 256 + c + ('a' - 'A')];
+                }
+            }
+            banned[node] = !banned[node];
+        }
+        m_filter = dfa(table, banned);
+    }
+
+    /// @brief Returns the automaton accepting the strings without banned words.
+    const dfa &filter() const
+    {
+        return m_filter;
+    }
+
+    /// @brief Returns the state of a streaming check before any byte.
+    uint32_t start() const
+    {
+        return m_filter.start();
+    }
+
+    /// @brief Advances a streaming check by one byte.
+    /// @param state the current state.
+    /// @param c the byte.
+    /// @return the next state.
+    uint32_t step(uint32_t state, unsigned char c) const
+    {
+        return m_filter.next(state, c);
+    }
+
+    /// @brief Returns true if a banned word has been found by a streaming check.
+    bool blocked(uint32_t state) const
+    {
+        return !m_filter.accepting(state);
+    }
+
+    /// @brief Returns true if the name contains a banned word.
+    bool contains(const std::string &name) const
+    {
+        return !m_filter.matches(name);
+    }
+
+private:
+    /// @brief Folds the case of a character, if requested and if it is an
+    /// ASCII letter, as std::tolower() does in the "C" locale.
+    static unsigned char fold(char c, bool ignore_case)
+    {
+        return static_cast<unsigned char>(c + ((ignore_case && (c >= 'A') && (c <= 'Z')) ? ('a' - 'A') : 0));
+    }
+
+    /// The automaton accepting the strings without banned words.
+    dfa m_filter;
+};
+
+/// @brief Generate a random name without banned words by retrying, checking
+/// each name in a single pass. Prefer a constrained_sampler built on
+/// blocklist::filter() when the pattern is used many times.
+/// @param buffer the string where the name is placed.
+/// @param compiled the compiled pattern.
+/// @param words the banned words.
+/// @param seed the seed used for random number generation.
+/// @param attempts the maximum number of names generated.
+/// @return SUCCESS, INVALID if the pattern was never compiled, or
+/// UNSATISFIABLE if all the attempts contained a banned word.
+inline return_code_t generate(std::string &buffer, const pattern &compiled, const blocklist &words, uint64_t &seed, std::size_t attempts)
+{
+    for (std::size_t i = 0; i < attempts; ++i) {
+        return_code_t ret = generate(buffer, compiled, seed);
+        if (ret != SUCCESS) {
+            return ret;
+        }
+        if (!words.contains(buffer)) {
+            return SUCCESS;
+        }
+    }
+    buffer.clear();
+    return UNSATISFIABLE;
+}
+
+} // namespace namegen
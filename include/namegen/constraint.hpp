@@ -0,0 +1,149 @@
+/// @file constraint.hpp
+/// @brief Generation of names constrained by a deterministic automaton.
+/// @details
+/// Generating names and discarding the ones that violate a constraint, like a
+/// required prefix, can take an unbounded number of attempts when the
+/// constraint is rarely met. The constrained_sampler intersects the automaton
+/// of a pattern with the automaton of the constraint, and computes for every
+/// pair of states the probability of completing a valid name from there. Names
+/// are then drawn directly from the intersection: they keep the probabilities
+/// generate() gives them, conditioned on the constraint, and no draw is ever
+/// rejected.
+
+#pragma once
+
+#include "namegen/automaton.hpp"
+
+namespace namegen
+{
+
+/// @brief The intersection of a pattern automaton with a constraint.
+/// @details The sampler keeps a reference to both automata, which must outlive
+/// it. Only the pairs of states reachable from the initial one are stored.
+class constrained_sampler {
+public:
+    /// @brief Intersects the automata.
+    /// @param names the automaton of the pattern.
+    /// @param constraint the automaton of the constraint.
+    constrained_sampler(const automaton &names, const dfa &constraint)
+        : m_names(&names),
+          m_constraint(&constraint),
+          m_first(names.size() + 1, 0)
+    {
+        // Forward pass: collect the reachable constraint states of each state.
+        std::vector<std::vector<uint32_t> > pending(names.size());
+        if (constraint.live(constraint.start())) {
+            pending[names.start()].push_back(constraint.start());
+        }
+        for (uint32_t s = 0; s < names.size(); ++s) {
+            std::vector<uint32_t> &states = pending[s];
+            std::sort(states.begin(), states.end());
+            states.erase(std::unique(states.begin(), states.end()), states.end());
+            m_states.insert(m_states.end(), states.begin(), states.end());
+            m_first[s + 1] = m_states.size();
+            for (std::size_t i = 0; i < states.size(); ++i) {
+                for (const automaton::edge *e = names.begin(s); e != names.end(s); ++e) {
+                    uint32_t next = this->step(states[i], e->symbol);
+                    if (constraint.live(next)) {
+                        pending[e->target].push_back(next);
+                    }
+                }
+            }
+            std::vector<uint32_t>().swap(states);
+        }
+        // Backward pass: the probability of completing an accepted name.
+        m_mass.resize(m_states.size(), 0.);
+        for (uint32_t s = static_cast<uint32_t>(names.size()); s-- > 0;) {
+            for (std::size_t i = m_first[s]; i < m_first[s + 1]; ++i) {
+                if (s == names.final_state()) {
+                    m_mass[i] = constraint.accepting(m_states[i]) ? 1. : 0.;
+                    continue;
+                }
+                for (const automaton::edge *e = names.begin(s); e != names.end(s); ++e) {
+                    m_mass[i] += e->weight * this->mass(e->target, this->step(m_states[i], e->symbol));
+                }
+            }
+        }
+    }
+
+    /// @brief Returns the probability that a name generated by the pattern
+    /// satisfies the constraint.
+    double probability() const
+    {
+        return this->mass(m_names->start(), m_constraint->start());
+    }
+
+private:
+    friend return_code_t generate(std::string &, const constrained_sampler &, uint64_t &);
+
+    /// @brief Follows an edge of the pattern inside the constraint.
+    uint32_t step(uint32_t state, int symbol) const
+    {
+        return (symbol == automaton::epsilon) ? state : m_constraint->next(state, static_cast<unsigned char>(symbol));
+    }
+
+    /// @brief Returns the probability of completing an accepted name from the
+    /// given pair of states.
+    double mass(uint32_t state, uint32_t constraint) const
+    {
+        std::vector<uint32_t>::const_iterator first = m_states.begin() + static_cast<std::ptrdiff_t>(m_first[state]);
+        std::vector<uint32_t>::const_iterator last  = m_states.begin() + static_cast<std::ptrdiff_t>(m_first[state + 1]);
+        std::vector<uint32_t>::const_iterator it    = std::lower_bound(first, last, constraint);
+        return ((it != last) && (*it == constraint)) ? m_mass[static_cast<std::size_t>(it - m_states.begin())] : 0.;
+    }
+
+    /// The automaton of the pattern.
+    const automaton *m_names;
+    /// The automaton of the constraint.
+    const dfa *m_constraint;
+    /// Where the constraint states of each state start.
+    std::vector<std::size_t> m_first;
+    /// The reachable constraint states, sorted, for each state.
+    std::vector<uint32_t> m_states;
+    /// The probability of completing an accepted name from each pair.
+    std::vector<double> m_mass;
+};
+
+/// @brief Generate a random name satisfying the constraint of the sampler,
+/// without rejecting any draw.
+/// @param buffer the string where the name is placed.
+/// @param sampler the intersection of the pattern with the constraint.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, or UNSATISFIABLE if no name of the pattern satisfies the
+/// constraint.
+inline return_code_t generate(std::string &buffer, const constrained_sampler &sampler, uint64_t &seed)
+{
+    buffer.clear();
+    const automaton &names = *sampler.m_names;
+    uint32_t state         = names.start();
+    uint32_t constraint    = sampler.m_constraint->start();
+    double total           = sampler.mass(state, constraint);
+    if (!(total > 0.)) {
+        return UNSATISFIABLE;
+    }
+    while (state != names.final_state()) {
+        // Take an edge proportionally to the mass it leads to.
+        double value                = static_cast<double>(detail::get_rand(seed)) / 4294967296.0 * total;
+        const automaton::edge *take = NULL;
+        double taken                = 0;
+        for (const automaton::edge *e = names.begin(state); e != names.end(state); ++e) {
+            double weight = e->weight * sampler.mass(e->target, sampler.step(constraint, e->symbol));
+            if (weight > 0.) {
+                take  = e;
+                taken = weight;
+                if ((value -= weight) < 0.) {
+                    break;
+                }
+            }
+        }
+        if (take->symbol != automaton::epsilon) {
+            buffer.push_back(static_cast<char>(take->symbol));
+        }
+        constraint = sampler.step(constraint, take->symbol);
+        state      = take->target;
+        total      = taken / take->weight;
+    }
+    return SUCCESS;
+}
+
+} // namespace namegen
@@ -0,0 +1,83 @@
+/// @file derive.hpp
+/// @brief Names derived from the identifiers of entities, without storage.
+/// @details
+/// name_for() hashes a key and the identifier of an entity into the seed of
+/// its name, so the name can be recomputed at any time, in the time it takes
+/// to generate one name, instead of being stored. Keys form a hierarchy: the
+/// key of a region derives from the key of its world, the key of a town from
+/// the key of its region, and so on, hence an entity only needs to know the
+/// path of identifiers that leads to it.
+///
+///     uint64_t region = namegen::derive_key(world, region_id);
+///     uint64_t town   = namegen::derive_key(region, town_id);
+///     namegen::name_for(name, npc_pattern, town, npc_id);
+///
+/// The name of an entity is the one a shared_generator with the same key gives
+/// to the counter equal to its identifier. Two patterns used for the same
+/// entity, like a first name and a surname, get the same seed: deriving a key
+/// per pattern, e.g. derive_key(town, "surname"), makes them independent.
+///
+/// The name depends on the engine of the pattern only if it was set to
+/// ENGINE_TABLE with set_engine(), which draws a different stream: patterns
+/// whose names are recomputed must keep the engine chosen by compile() or
+/// calibrate().
+
+#pragma once
+
+#include "namegen/shared_generator.hpp"
+
+namespace namegen
+{
+
+/// @brief Derives the key of a child from the key of its parent.
+/// @param parent the key of the parent.
+/// @param child the identifier of the child.
+/// @return the key of the child.
+inline uint64_t derive_key(uint64_t parent, uint64_t child)
+{
+    // Keeps derived keys apart from the seeds of the names.
+    return detail::mix(detail::stream_seed(parent, child) ^ 0x6a09e667f3bcc908ULL);
+}
+
+/// @brief Derives the key of a child, identified by a label, from the key of
+/// its parent.
+/// @param parent the key of the parent.
+/// @param label the label of the child.
+/// @return the key of the child.
+inline uint64_t derive_key(uint64_t parent, const std::string &label)
+{
+    // 64-bit FNV-1a of the label.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < label.size(); ++i) {
+        hash = (hash ^ static_cast<unsigned char>(label[i])) * 0x100000001b3ULL;
+    }
+    return derive_key(parent, hash);
+}
+
+/// @brief Derives a key by following a path of identifiers.
+/// @param root the key of the root.
+/// @param path the identifiers, from the child of the root down.
+/// @param depth the number of identifiers.
+/// @return the key at the end of the path.
+inline uint64_t derive_key(uint64_t root, const uint64_t *path, std::size_t depth)
+{
+    for (std::size_t i = 0; i < depth; ++i) {
+        root = derive_key(root, path[i]);
+    }
+    return root;
+}
+
+/// @brief Generates the name of an entity, always the same for the same key
+/// and identifier, unless the engine of the pattern is set to ENGINE_TABLE.
+/// @param buffer the string where the name is placed.
+/// @param compiled the compiled pattern.
+/// @param key the key of the parent of the entity, e.g. of its world.
+/// @param id the identifier of the entity.
+/// @return the same codes of generate().
+inline return_code_t name_for(std::string &buffer, const pattern &compiled, uint64_t key, uint64_t id)
+{
+    uint64_t seed = detail::stream_seed(key, id);
+    return generate(buffer, compiled, seed);
+}
+
+} // namespace namegen
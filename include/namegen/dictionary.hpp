@@ -0,0 +1,160 @@
+/// @file dictionary.hpp
+/// @brief User token tables, bound to the keys of a pattern.
+/// @details
+/// A dictionary maps the keys of a pattern to token tables. Keys without a
+/// table of their own fall back to the built-in ones, so a dictionary can both
+/// add new token classes and replace, or re-weight, the built-in ones.
+///
+/// Tables can also be bound to names, made of letters, digits and
+/// underscores, which patterns reference with a dollar sign: "<$elf_prefix>s"
+/// emits a token of the table named "elf_prefix", followed by a syllable.
+/// Names are resolved once, when the pattern is compiled, so the generation
+/// reaches the table through a pointer, no matter how many names there are.
+/// A dollar sign followed by a name without a table, or by no name at all, is
+/// emitted literally, as the single-pass generator does.
+
+#pragma once
+
+#include "namegen/table.hpp"
+
+#include <deque>
+#include <map>
+#include <memory>
+
+namespace namegen
+{
+
+/// @brief Maps the keys of a pattern to token tables.
+/// @details Patterns compiled with a dictionary point inside it, hence the
+/// dictionary must outlive them, and must not be changed meanwhile.
+class dictionary {
+public:
+    /// @brief Creates a dictionary with only the built-in tables.
+    dictionary()
+        : m_tables(),
+          m_names(),
+          m_storage()
+    {
+        for (std::size_t i = 0; i < 256; ++i) {
+            m_index[i] = no_table;
+        }
+    }
+
+    /// @brief Binds a table to a key, replacing the previous one.
+    /// @param key the key, any character but the ones of the pattern syntax.
+    /// @param table the table, it is copied.
+    /// @return false if the key is reserved.
+    bool insert(unsigned char key, const token_table &table)
+    {
+        if (is_reserved(key)) {
+            return false;
+        }
+        if (m_index[key] == no_table) {
+            m_index[key] = static_cast<uint32_t>(m_tables.size());
+            m_tables.push_back(table);
+        } else {
+            m_tables[m_index[key]] = table;
+        }
+        return true;
+    }
+
+    /// @brief Binds a table to a name, replacing the previous one.
+    /// @param name the name, made of letters, digits and underscores.
+    /// @param table the table, it is copied.
+    /// @return false if the name is not valid.
+    bool insert(const std::string &name, const token_table &table)
+    {
+        if (name.empty()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < name.size(); ++i) {
+            if (!is_name(static_cast<unsigned char>(name[i]))) {
+                return false;
+            }
+        }
+        std::map<std::string, uint32_t>::const_iterator it = m_names.find(name);
+        if (it == m_names.end()) {
+            m_names[name] = static_cast<uint32_t>(m_tables.size());
+            m_tables.push_back(table);
+        } else {
+            m_tables[it->second] = table;
+        }
+        return true;
+    }
+
+    /// @brief Returns the table bound to a name.
+    /// @param name the name.
+    /// @return the table, or NULL if there is none.
+    const token_table *find(const std::string &name) const
+    {
+        std::map<std::string, uint32_t>::const_iterator it = m_names.find(name);
+        return (it == m_names.end()) ? NULL : &m_tables[it->second];
+    }
+
+    /// @brief Returns the table bound to a key.
+    /// @param key the key.
+    /// @return the user table, the built-in one if there is none, or NULL if
+    /// neither exists and the key is emitted literally.
+    const token_table *find(unsigned char key) const
+    {
+        return (m_index[key] == no_table) ? detail::get_table(key) : &m_tables[m_index[key]];
+    }
+
+    /// @brief Returns the keys bound to a user table.
+    std::vector<unsigned char> keys() const
+    {
+        std::vector<unsigned char> result;
+        for (std::size_t i = 0; i < 256; ++i) {
+            if (m_index[i] != no_table) {
+                result.push_back(static_cast<unsigned char>(i));
+            }
+        }
+        return result;
+    }
+
+    /// @brief Returns the names bound to a table, in lexicographic order.
+    std::vector<std::string> names() const
+    {
+        std::vector<std::string> result;
+        for (std::map<std::string, uint32_t>::const_iterator it = m_names.begin(); it != m_names.end(); ++it) {
+            result.push_back(it->first);
+        }
+        return result;
+    }
+
+    /// @brief Keeps some memory alive as long as the dictionary, or any of its
+    /// copies, for the tables that view it.
+    /// @param storage the memory.
+    void retain(const std::shared_ptr<const void> &storage)
+    {
+        m_storage.push_back(storage);
+    }
+
+    /// @brief Returns true if the key is part of the pattern syntax.
+    static bool is_reserved(unsigned char key)
+    {
+        return (key == '<') || (key == '>') || (key == '(') || (key == ')') ||
+               (key == '|') || (key == '!') || (key == ':') || (key == '$') || (key == 0);
+    }
+
+    /// @brief Returns true if the character can be part of a name.
+    static bool is_name(unsigned char c)
+    {
+        return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '_');
+    }
+
+private:
+    /// Marks a key without a user table.
+    enum { no_table = 0xffffffffU };
+
+    /// The user tables, a deque keeps them in place while it grows.
+    std::deque<token_table> m_tables;
+    /// The index of the table of each name.
+    std::map<std::string, uint32_t> m_names;
+    /// The index of the table of each key.
+    uint32_t m_index[256];
+    /// The memory viewed by the tables.
+    std::vector<std::shared_ptr<const void> > m_storage;
+};
+
+} // namespace namegen
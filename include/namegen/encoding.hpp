@@ -0,0 +1,356 @@
+/// @file encoding.hpp
+/// @brief Compact encoding of generated names.
+/// @details
+/// Every name is a concatenation of table tokens and literals, and the
+/// literals are fixed by the pattern. Hence, given the pattern, a name is
+/// fully described by the choices taken while generating it: the selected
+/// alternative of each group with more than one option, and the selected token
+/// of each table with more than one entry. The encoding stores exactly those
+/// indices, one byte each (indices above 127 take more bytes, LEB128-style),
+/// in a fixed-size object of 16 bytes.
+///
+/// Equal encodings of the same pattern always decode to the same name. The
+/// converse does not hold for ambiguous patterns, like "<v|V>", where
+/// different choices can spell the same name.
+
+#pragma once
+
+#include "namegen/pattern.hpp"
+
+#include <cstring>
+#include <functional>
+
+/// Number of bytes an encoded name can hold.
+#define NAME_ENCODED_CAPACITY 15
+
+namespace namegen
+{
+
+/// @brief A name stored as the sequence of choices that generated it.
+class encoded_name {
+public:
+    /// @brief Creates an empty encoding.
+    encoded_name()
+        : m_size(0)
+    {
+    }
+
+    /// @brief Returns the number of bytes of the encoding.
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    /// @brief Returns true if the encoding contains no bytes.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /// @brief Returns the bytes of the encoding.
+    const uint8_t *data() const
+    {
+        return m_data;
+    }
+
+    /// @brief Returns the byte at the given position.
+    uint8_t operator[](std::size_t index) const
+    {
+        return m_data[index];
+    }
+
+    /// @brief Removes all the bytes.
+    void clear()
+    {
+        m_size = 0;
+    }
+
+    /// @brief Appends a byte.
+    /// @param byte the byte to append.
+    /// @return false if the encoding is full.
+    bool push_back(uint8_t byte)
+    {
+        if (m_size == NAME_ENCODED_CAPACITY) {
+            return false;
+        }
+        m_data[m_size++] = byte;
+        return true;
+    }
+
+    /// @brief Shrinks the encoding to the given size.
+    /// @param size the new size, which must not exceed the current one.
+    void truncate(std::size_t size)
+    {
+        if (size < m_size) {
+            m_size = static_cast<uint8_t>(size);
+        }
+    }
+
+    /// @brief Computes a hash of the encoding (64-bit FNV-1a).
+    std::size_t hash() const
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            hash = (hash ^ m_data[i]) * 0x100000001b3ULL;
+        }
+        return static_cast<std::size_t>(hash ^ m_size);
+    }
+
+    friend bool operator==(const encoded_name &lhs, const encoded_name &rhs)
+    {
+        return (lhs.m_size == rhs.m_size) && (std::memcmp(lhs.m_data, rhs.m_data, lhs.m_size) == 0);
+    }
+
+    friend bool operator!=(const encoded_name &lhs, const encoded_name &rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend bool operator<(const encoded_name &lhs, const encoded_name &rhs)
+    {
+        int result = std::memcmp(lhs.m_data, rhs.m_data, (lhs.m_size < rhs.m_size) ? lhs.m_size : rhs.m_size);
+        return (result < 0) || ((result == 0) && (lhs.m_size < rhs.m_size));
+    }
+
+private:
+    /// The encoded choices.
+    uint8_t m_data[NAME_ENCODED_CAPACITY];
+    /// The number of bytes used.
+    uint8_t m_size;
+};
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Records the choices taken during generation inside an encoded name.
+/// @details Bytes that do not fit are dropped but still counted, because they
+/// may belong to an alternative which is later discarded.
+class encoder {
+public:
+    /// @brief Records inside the given encoded name, which is cleared.
+    explicit encoder(encoded_name &name)
+        : m_name(name),
+          m_size(0)
+    {
+        m_name.clear();
+    }
+
+    /// @brief Returns true if all the recorded bytes fit in the encoding.
+    bool fits() const
+    {
+        return m_size <= NAME_ENCODED_CAPACITY;
+    }
+
+    /// @brief Returns the current position of the record.
+    std::size_t mark() const
+    {
+        return m_size;
+    }
+
+    /// @brief Discards everything recorded after the given position.
+    void rewind(std::size_t mark)
+    {
+        m_size = mark;
+        m_name.truncate(mark);
+    }
+
+    /// @brief Records the index of a choice.
+    void choice(std::size_t index)
+    {
+        do {
+            uint8_t byte = static_cast<uint8_t>(index & 0x7f);
+            if ((index >>= 7) != 0) {
+                byte |= 0x80;
+            }
+            if (m_size++ < NAME_ENCODED_CAPACITY) {
+                m_name.push_back(byte);
+            }
+        } while (index);
+    }
+
+private:
+    /// The encoding we write.
+    encoded_name &m_name;
+    /// The number of bytes recorded so far.
+    std::size_t m_size;
+};
+
+/// @brief Reads the index of a choice from the encoding.
+/// @param name the encoding.
+/// @param position the current reading position, it is modified.
+/// @param index the decoded index.
+/// @return false if the encoding ends prematurely, or if the index does not
+/// fit in a size_t.
+inline bool read_choice(const encoded_name &name, std::size_t &position, std::size_t &index)
+{
+    index = 0;
+    for (unsigned shift = 0; position < name.size(); shift += 7) {
+        if (shift > sizeof(std::size_t) * 8 - 7) {
+            return false;
+        }
+        uint8_t byte = name[position++];
+        index |= static_cast<std::size_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool decode_group(const pattern &, std::size_t, const encoded_name &, std::size_t &, std::string &, std::size_t &, bool &);
+
+/// @brief Decodes the given alternative.
+/// @param compiled the compiled pattern.
+/// @param index the index of the alternative.
+/// @param name the encoding.
+/// @param position the current reading position.
+/// @param buffer the buffer we manipulate.
+/// @param location the current output location.
+/// @param capitalize the capitalization flag.
+/// @return false if the encoding does not belong to the pattern.
+inline bool decode_alternative(
+    const pattern &compiled,
+    std::size_t index,
+    const encoded_name &name,
+    std::size_t &position,
+    std::string &buffer,
+    std::size_t &location,
+    bool &capitalize)
+{
+    const pattern::alternative &alternative = compiled.alternatives[index];
+    for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+        const pattern::item &item = compiled.items[i];
+        if (item.kind == pattern::ITEM_TOKEN) {
+            std::size_t select = 0;
+            if ((item.table->size() > 1) && (!read_choice(name, position, select) || (select >= item.table->size()))) {
+                return false;
+            }
+            emit_token(buffer, location, item.table->token(select), item.table->length(select), capitalize);
+            capitalize = false;
+        } else if (item.kind == pattern::ITEM_LITERAL) {
+            emit_literal(buffer, location, item.value, capitalize);
+            capitalize = false;
+        } else if (item.kind == pattern::ITEM_CAPITALIZE) {
+            capitalize = true;
+        } else if (!decode_group(compiled, item.group, name, position, buffer, location, capitalize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Decodes the given group.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @param name the encoding.
+/// @param position the current reading position.
+/// @param buffer the buffer we manipulate.
+/// @param location the current output location.
+/// @param capitalize the capitalization flag.
+/// @return false if the encoding does not belong to the pattern.
+inline bool decode_group(
+    const pattern &compiled,
+    std::size_t index,
+    const encoded_name &name,
+    std::size_t &position,
+    std::string &buffer,
+    std::size_t &location,
+    bool &capitalize)
+{
+    const pattern::group &group = compiled.groups[index];
+    std::size_t select          = 0;
+    if (((group.last - group.first) > 1) &&
+        (!read_choice(name, position, select) || (select >= (group.last - group.first)))) {
+        return false;
+    }
+    // The selected alternative starts with the capitalization the group was
+    // entered with, the ones that follow it are skipped.
+    const pattern::alternative &alternative = compiled.alternatives[group.first + select];
+    if (!decode_alternative(compiled, group.first + select, name, position, buffer, location, capitalize)) {
+        return false;
+    }
+    capitalize = apply_effect(alternative.tail, capitalize);
+    return true;
+}
+
+} // namespace detail
+
+/// @brief Generate a random name based on a compiled pattern and a given seed,
+/// saving both the name and its encoding.
+/// @details The choices are recorded while walking the tree, whatever the
+/// engine of the pattern: the name is the one ENGINE_TREE and ENGINE_BYTECODE
+/// give for the seed, not the one of ENGINE_TABLE, which draws another stream.
+/// @param buffer the string where the name is placed.
+/// @param name the encoding of the generated name.
+/// @param compiled the compiled pattern.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, INVALID if the pattern was never compiled, or TOO_LONG if
+/// the encoding does not fit inside an encoded_name.
+inline return_code_t generate(std::string &buffer, encoded_name &name, const pattern &compiled, uint64_t &seed)
+{
+    detail::encoder encoder(name);
+    if (compiled.groups.empty()) {
+        buffer.clear();
+        return INVALID;
+    }
+    std::size_t location = 0;
+    bool capitalize      = false;
+    detail::run_group(compiled, 0, buffer, location, capitalize, seed, encoder);
+    buffer.resize(location);
+    if (!encoder.fits()) {
+        buffer.clear();
+        name.clear();
+        return TOO_LONG;
+    }
+    return SUCCESS;
+}
+
+/// @brief Generate a random name based on a compiled pattern and a given seed,
+/// keeping only its encoding. Like generate(), it walks the tree whatever the
+/// engine of the pattern.
+/// @param name the encoding of the generated name.
+/// @param compiled the compiled pattern.
+/// @param seed the seed used for random number generation.
+/// @return the same codes of generate().
+inline return_code_t encode(encoded_name &name, const pattern &compiled, uint64_t &seed)
+{
+    std::string buffer;
+    return generate(buffer, name, compiled, seed);
+}
+
+/// @brief Rebuilds a name from its encoding.
+/// @param buffer the string where the name is placed.
+/// @param compiled the compiled pattern that generated the name.
+/// @param name the encoding of the name.
+/// @return SUCCESS, or INVALID if the encoding does not belong to the pattern.
+inline return_code_t decode(std::string &buffer, const pattern &compiled, const encoded_name &name)
+{
+    std::size_t position = 0;
+    std::size_t location = 0;
+    bool capitalize      = false;
+    if (compiled.groups.empty() ||
+        !detail::decode_group(compiled, 0, name, position, buffer, location, capitalize) ||
+        (position != name.size())) {
+        buffer.clear();
+        return INVALID;
+    }
+    buffer.resize(location);
+    return SUCCESS;
+}
+
+} // namespace namegen
+
+namespace std
+{
+
+/// @brief Hashes encoded names, so that they can be used in unordered containers.
+template <>
+struct hash<namegen::encoded_name> {
+    std::size_t operator()(const namegen::encoded_name &name) const
+    {
+        return name.hash();
+    }
+};
+
+} // namespace std
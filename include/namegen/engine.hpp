@@ -0,0 +1,121 @@
+/// @file engine.hpp
+/// @brief Selection of the engine that generates the names of a pattern.
+/// @details
+/// compile() chooses the engine of a pattern from a static estimate of the
+/// cost of a name with each engine, which is enough for most patterns, since
+/// the engines are far apart where it matters. calibrate() replaces the
+/// estimate with the time a name takes on the host, measured on a few
+/// rounds of names, for the patterns where a wrong guess is costly:
+///
+///     namegen::pattern compiled;
+///     namegen::compile(compiled, "<v|V>(dim)");
+///     namegen::calibrate(compiled);
+///
+/// Both compile() and calibrate() choose between the tree and the bytecode,
+/// which draw the same numbers and give the same name for the same seed, so
+/// the choice depends on the host but the names do not. The table of a
+/// materialized pattern follows the same distribution of names, but draws a
+/// different stream: with it, a seed gives a different name than with the
+/// other engines, or the single-pass generator. It is only ever selected
+/// explicitly, with set_engine(), and must not be selected for a pattern whose
+/// names are recomputed from their seed, like the ones of name_for() and
+/// shared_generator::at(), or compared with the names of patternc and
+/// static_pattern.
+
+#pragma once
+
+#include "namegen/pattern.hpp"
+
+#include <chrono>
+
+/// Number of names generated by calibrate(), per round and engine.
+#define NAME_CALIBRATION_NAMES 1024
+
+/// Number of rounds timed by calibrate(), per engine.
+#define NAME_CALIBRATION_ROUNDS 5
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Measures the time a name takes with the engine of the pattern.
+/// @param compiled the compiled pattern.
+/// @param names the number of names to generate, per round.
+/// @return the time of a name, in tenths of a nanosecond.
+inline double measure_engine(const pattern &compiled, std::size_t names)
+{
+    std::string buffer;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    // Warms up the caches, and the buffer.
+    for (std::size_t i = 0; i < names / 8; ++i) {
+        generate(buffer, compiled, seed);
+    }
+    // The fastest of a few rounds is the least disturbed by the rest of the
+    // system.
+    typedef std::chrono::steady_clock clock;
+    double best = std::numeric_limits<double>::infinity();
+    for (unsigned round = 0; round < NAME_CALIBRATION_ROUNDS; ++round) {
+        clock::time_point start = clock::now();
+        for (std::size_t i = 0; i < names; ++i) {
+            generate(buffer, compiled, seed);
+        }
+        std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return names ? best * 10. / static_cast<double>(names) : 0.;
+}
+
+} // namespace detail
+
+/// @brief Sets the engine that generates the names of a pattern.
+/// @details ENGINE_TABLE gives other names for the same seeds than the other
+/// engines, and materializes the outputs of the pattern the first time it is
+/// selected.
+/// @param compiled the compiled pattern.
+/// @param engine the engine.
+/// @return SUCCESS, or INVALID if the pattern was never compiled, or if the
+/// engine is ENGINE_TABLE and the pattern has more than
+/// NAME_MATERIALIZE_LIMIT derivations, in which case the engine is left
+/// unchanged.
+inline return_code_t set_engine(pattern &compiled, pattern::engine_t engine)
+{
+    if (compiled.groups.empty() || ((engine == pattern::ENGINE_TABLE) && !detail::build_outputs(compiled))) {
+        return INVALID;
+    }
+    compiled.engine = engine;
+    return SUCCESS;
+}
+
+/// @brief Times every engine available to the pattern on the host, stores
+/// the times in place of the estimated costs, and selects the fastest of the
+/// tree and the bytecode. The table is timed too, when the pattern has few
+/// enough derivations to be materialized, but never selected: set_engine()
+/// does it, for the patterns that do not need the names of the other engines.
+/// @param compiled the compiled pattern.
+/// @param names the number of names generated per round, with each engine.
+/// @return SUCCESS, or INVALID if the pattern was never compiled.
+inline return_code_t calibrate(pattern &compiled, std::size_t names = NAME_CALIBRATION_NAMES)
+{
+    if (compiled.groups.empty()) {
+        return INVALID;
+    }
+    if (detail::build_outputs(compiled)) {
+        compiled.engine     = pattern::ENGINE_TABLE;
+        compiled.cost.table = detail::measure_engine(compiled, names);
+    }
+    compiled.engine        = pattern::ENGINE_TREE;
+    compiled.cost.tree     = detail::measure_engine(compiled, names);
+    compiled.engine        = pattern::ENGINE_BYTECODE;
+    compiled.cost.bytecode = detail::measure_engine(compiled, names);
+    if (compiled.cost.bytecode <= compiled.cost.tree) {
+        compiled.engine = pattern::ENGINE_BYTECODE;
+    } else {
+        compiled.engine = pattern::ENGINE_TREE;
+    }
+    return SUCCESS;
+}
+
+} // namespace namegen
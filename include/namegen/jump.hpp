@@ -0,0 +1,107 @@
+/// @file jump.hpp
+/// @brief Jump-ahead and substreams of the xorshift generator.
+/// @details
+/// Every step of the generator behind detail::get_rand() is made of shifts
+/// and exclusive ors, hence it is a linear map over GF(2), a 64x64 matrix of
+/// bits, and k steps are the k-th power of that matrix. The matrices of the
+/// steps by 1, 2, 4, ... 2^63 draws are computed once, so jump() advances a
+/// seed by any number of draws with at most 64 matrix-vector products.
+///
+/// The low 32 bits of the seed, which are the numbers drawn, evolve on their
+/// own: they repeat after exactly NAME_RAND_PERIOD draws, for any seed whose
+/// low 32 bits are not all zero. split() divides that period into windows,
+/// one per substream, which do not overlap as long as no substream draws more
+/// than its share.
+
+#pragma once
+
+#include "namegen/namegen.hpp"
+
+#include <vector>
+
+/// Number of draws after which the numbers drawn repeat.
+#define NAME_RAND_PERIOD 0xffffffffULL
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Applies a linear map over GF(2) to a 64-bit vector.
+/// @param matrix the images of the 64 unit vectors.
+/// @param value the vector.
+/// @return the image of the vector.
+inline uint64_t gf2_apply(const uint64_t *matrix, uint64_t value)
+{
+    uint64_t result = 0;
+    for (unsigned i = 0; value; ++i, value >>= 1) {
+        if (value & 1U) {
+            result ^= matrix[i];
+        }
+    }
+    return result;
+}
+
+/// @brief The matrices of the steps by all the powers of two of draws.
+struct jump_table {
+    /// The images of the unit vectors after 2^i draws.
+    uint64_t powers[64][64];
+
+    jump_table()
+    {
+        for (unsigned i = 0; i < 64; ++i) {
+            uint64_t seed = 1ULL << i;
+            get_rand(seed);
+            powers[0][i] = seed;
+        }
+        for (unsigned i = 1; i < 64; ++i) {
+            for (unsigned j = 0; j < 64; ++j) {
+                powers[i][j] = gf2_apply(powers[i - 1], powers[i - 1][j]);
+            }
+        }
+    }
+};
+
+/// @brief Returns the matrices of the steps, computed on the first call.
+inline const jump_table &get_jump_table()
+{
+    static const jump_table table;
+    return table;
+}
+
+} // namespace detail
+
+/// @brief Advances the seed as if the given number of random numbers had been
+/// drawn from it.
+/// @param seed the seed to advance.
+/// @param draws the number of draws to skip.
+inline void jump(uint64_t &seed, uint64_t draws)
+{
+    const detail::jump_table &table = detail::get_jump_table();
+    for (unsigned i = 0; draws; ++i, draws >>= 1) {
+        if (draws & 1U) {
+            seed = detail::gf2_apply(table.powers[i], seed);
+        }
+    }
+}
+
+/// @brief Derives the seeds of substreams which draw different numbers.
+/// @param seed the seed of the whole stream, which must not have all the low
+/// 32 bits set to zero.
+/// @param count the number of substreams.
+/// @return the seeds, the first one being the given seed. Each substream can
+/// draw up to NAME_RAND_PERIOD / count numbers without running into the next.
+inline std::vector<uint64_t> split(uint64_t seed, std::size_t count)
+{
+    std::vector<uint64_t> seeds(count);
+    uint64_t stride = count ? NAME_RAND_PERIOD / count : 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        seeds[i] = seed;
+        jump(seed, stride);
+    }
+    return seeds;
+}
+
+} // namespace namegen
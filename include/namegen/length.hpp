@@ -0,0 +1,309 @@
+/// @file length.hpp
+/// @brief Generation of names whose length falls inside a given range.
+/// @details
+/// Looping over generate() until the length fits wastes most of the draws
+/// when the range is rare. Instead, the length_sampler counts, for every node
+/// of the compiled pattern, how many outputs of each length the node can
+/// produce. A length is then drawn among the admissible ones, and split top-down
+/// among the nodes, so that no draw is ever rejected and the cost does not
+/// depend on how rare the range is.
+
+#pragma once
+
+#include "namegen/pattern.hpp"
+
+namespace namegen
+{
+
+/// @brief How the outputs of a pattern are weighted when sampling by length.
+enum length_weighting_t {
+    UNIFORM_DERIVATIONS, ///< Every way of generating a name is equally likely.
+    PATTERN_DISTRIBUTION ///< Names keep the probabilities generate() gives them.
+};
+
+/// @brief Length-count tables over a compiled pattern.
+/// @details The sampler keeps a reference to the pattern, which must outlive it.
+class length_sampler {
+public:
+    /// @brief Computes the tables of the given pattern.
+    /// @param compiled the compiled pattern.
+    /// @param weighting how outputs are weighted.
+    explicit length_sampler(const pattern &compiled, length_weighting_t weighting = UNIFORM_DERIVATIONS)
+        : m_pattern(&compiled),
+          m_weighting(weighting),
+          m_items(compiled.items.size()),
+          m_groups(compiled.groups.size()),
+          m_prefix_offset(compiled.alternatives.size())
+    {
+        // Nested groups always come after their parent.
+        for (std::size_t g = compiled.groups.size(); g-- > 0;) {
+            const pattern::group &group = compiled.groups[g];
+            for (std::size_t a = group.first; a < group.last; ++a) {
+                const pattern::alternative &alternative = compiled.alternatives[a];
+                // Prefix m holds the lengths of the first m items.
+                m_prefix_offset[a] = m_prefix.size();
+                m_prefix.push_back(distribution(1, 1.));
+                for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+                    this->compute_item(i);
+                    m_prefix.push_back(convolve(m_prefix.back(), this->item_lengths(i)));
+                }
+                accumulate(m_groups[g], m_prefix.back(), this->alternative_weight(a));
+            }
+        }
+    }
+
+    /// @brief Returns the pattern the tables were computed for.
+    const pattern &compiled() const
+    {
+        return *m_pattern;
+    }
+
+    /// @brief Returns the length of the longest output.
+    std::size_t max_length() const
+    {
+        return m_groups.empty() ? 0 : m_groups[0].size() - 1;
+    }
+
+    /// @brief Returns the total weight of the outputs with the given length,
+    /// that is their number for UNIFORM_DERIVATIONS, or their probability for
+    /// PATTERN_DISTRIBUTION.
+    double count(std::size_t length) const
+    {
+        return (length <= this->max_length()) ? m_groups[0][length] : 0;
+    }
+
+private:
+    /// Weights of the outputs, indexed by length.
+    typedef std::vector<double> distribution;
+
+    friend return_code_t generate(std::string &, const length_sampler &, std::size_t, std::size_t, uint64_t &);
+
+    /// @brief Returns the weight of an alternative inside its group, alternatives
+    /// which are never selected do not count as derivations.
+    double alternative_weight(std::size_t index) const
+    {
+        double probability = m_pattern->alternatives[index].probability;
+        return (m_weighting == UNIFORM_DERIVATIONS) ? (probability > 0. ? 1. : 0.) : probability;
+    }
+
+    /// @brief Returns the weight of a single token inside its table, tokens
+    /// which are never selected do not count as derivations.
+    double token_weight(const pattern::item &item, std::size_t index) const
+    {
+        double probability = detail::token_probability(item, index);
+        return (m_weighting == UNIFORM_DERIVATIONS) ? (probability > 0. ? 1. : 0.) : probability;
+    }
+
+    /// @brief Returns the distribution of the given item.
+    const distribution &item_lengths(std::size_t index) const
+    {
+        const pattern::item &item = m_pattern->items[index];
+        return (item.kind == pattern::ITEM_GROUP) ? m_groups[item.group] : m_items[index];
+    }
+
+    /// @brief Computes the distribution of an item which is not a group.
+    void compute_item(std::size_t index)
+    {
+        const pattern::item &item = m_pattern->items[index];
+        distribution &lengths     = m_items[index];
+        if (item.kind == pattern::ITEM_TOKEN) {
+            for (std::size_t i = 0; i < item.table->size(); ++i) {
+                std::size_t size = item.table->length(i);
+                if (size >= lengths.size()) {
+                    lengths.resize(size + 1, 0.);
+                }
+                lengths[size] += this->token_weight(item, i);
+            }
+        } else if (item.kind == pattern::ITEM_LITERAL) {
+            lengths.assign(2, 0.);
+            lengths[1] = 1;
+        } else if (item.kind == pattern::ITEM_CAPITALIZE) {
+            lengths.assign(1, 1.);
+        }
+    }
+
+    /// @brief Computes the distribution of the concatenation of two outputs.
+    static distribution convolve(const distribution &lhs, const distribution &rhs)
+    {
+        distribution result(lhs.size() + rhs.size() - 1, 0.);
+        for (std::size_t i = 0; i < lhs.size(); ++i) {
+            for (std::size_t j = 0; (j < rhs.size()) && (lhs[i] != 0.); ++j) {
+                result[i + j] += lhs[i] * rhs[j];
+            }
+        }
+        return result;
+    }
+
+    /// @brief Adds a weighted distribution to another one.
+    static void accumulate(distribution &result, const distribution &lengths, double weight)
+    {
+        if (lengths.size() > result.size()) {
+            result.resize(lengths.size(), 0.);
+        }
+        for (std::size_t i = 0; i < lengths.size(); ++i) {
+            result[i] += lengths[i] * weight;
+        }
+    }
+
+    /// @brief Returns the weight of a given length.
+    static double at(const distribution &lengths, std::size_t length)
+    {
+        return (length < lengths.size()) ? lengths[length] : 0.;
+    }
+
+    /// @brief Draws a uniform value in [0, total).
+    static double draw(uint64_t &seed, double total)
+    {
+        return static_cast<double>(detail::get_rand(seed)) / 4294967296.0 * total;
+    }
+
+    /// @brief Generates a group with an output of the given length.
+    void render_group(std::size_t index, std::size_t length, std::string &buffer, std::size_t &location, bool &capitalize, uint64_t &seed) const
+    {
+        const pattern::group &group = m_pattern->groups[index];
+        // Pick an alternative, proportionally to its outputs of that length.
+        double total = 0;
+        for (std::size_t a = group.first; a < group.last; ++a) {
+            total += this->alternative_weight(a) * at(m_prefix[m_prefix_offset[a] + this->size(a)], length);
+        }
+        double value       = draw(seed, total);
+        std::size_t select = group.last;
+        for (std::size_t a = group.first; a < group.last; ++a) {
+            double weight = this->alternative_weight(a) * at(m_prefix[m_prefix_offset[a] + this->size(a)], length);
+            if (weight > 0.) {
+                select = a;
+                if ((value -= weight) < 0.) {
+                    break;
+                }
+            }
+        }
+        this->render_alternative(select, length, buffer, location, capitalize, seed);
+        capitalize = detail::apply_effect(m_pattern->alternatives[select].tail, capitalize);
+    }
+
+    /// @brief Generates an alternative with an output of the given length.
+    void render_alternative(std::size_t index, std::size_t length, std::string &buffer, std::size_t &location, bool &capitalize, uint64_t &seed) const
+    {
+        const pattern::alternative &alternative = m_pattern->alternatives[index];
+        // Split the length among the items, starting from the last one.
+        std::vector<std::size_t> lengths(this->size(index));
+        for (std::size_t m = lengths.size(); m-- > 0;) {
+            const distribution &item   = this->item_lengths(alternative.first + m);
+            const distribution &prefix = m_prefix[m_prefix_offset[index] + m];
+            double total               = 0;
+            for (std::size_t l = 0; (l < item.size()) && (l <= length); ++l) {
+                total += item[l] * at(prefix, length - l);
+            }
+            double value = draw(seed, total);
+            for (std::size_t l = 0; (l < item.size()) && (l <= length); ++l) {
+                double weight = item[l] * at(prefix, length - l);
+                if (weight > 0.) {
+                    lengths[m] = l;
+                    if ((value -= weight) < 0.) {
+                        break;
+                    }
+                }
+            }
+            length -= lengths[m];
+        }
+        for (std::size_t m = 0; m < lengths.size(); ++m) {
+            const pattern::item &item = m_pattern->items[alternative.first + m];
+            if (item.kind == pattern::ITEM_TOKEN) {
+                this->render_token(item, lengths[m], buffer, location, capitalize, seed);
+                capitalize = false;
+            } else if (item.kind == pattern::ITEM_LITERAL) {
+                detail::emit_literal(buffer, location, item.value, capitalize);
+                capitalize = false;
+            } else if (item.kind == pattern::ITEM_CAPITALIZE) {
+                capitalize = true;
+            } else {
+                this->render_group(item.group, lengths[m], buffer, location, capitalize, seed);
+            }
+        }
+    }
+
+    /// @brief Generates a token of the given length.
+    void render_token(const pattern::item &item, std::size_t length, std::string &buffer, std::size_t &location, bool capitalize, uint64_t &seed) const
+    {
+        const token_table &table = *item.table;
+        double total             = 0;
+        for (std::size_t i = 0; i < table.size(); ++i) {
+            total += (table.length(i) == length) ? this->token_weight(item, i) : 0.;
+        }
+        double value       = draw(seed, total);
+        std::size_t select = table.size();
+        for (std::size_t i = 0; i < table.size(); ++i) {
+            double weight = (table.length(i) == length) ? this->token_weight(item, i) : 0.;
+            if (weight > 0.) {
+                select = i;
+                if ((value -= weight) < 0.) {
+                    break;
+                }
+            }
+        }
+        detail::emit_token(buffer, location, table.token(select), table.length(select), capitalize);
+    }
+
+    /// @brief Returns the number of items of an alternative.
+    std::size_t size(std::size_t index) const
+    {
+        return m_pattern->alternatives[index].last - m_pattern->alternatives[index].first;
+    }
+
+    /// The compiled pattern.
+    const pattern *m_pattern;
+    /// How outputs are weighted.
+    length_weighting_t m_weighting;
+    /// The distribution of each item which is not a group.
+    std::vector<distribution> m_items;
+    /// The distribution of each group.
+    std::vector<distribution> m_groups;
+    /// The distributions of the prefixes of each alternative.
+    std::vector<distribution> m_prefix;
+    /// Where the prefixes of each alternative start.
+    std::vector<std::size_t> m_prefix_offset;
+};
+
+/// @brief Generate a random name whose length is between min and max, both
+/// included, without rejecting any draw.
+/// @param buffer the string where the name is placed.
+/// @param sampler the length tables of the pattern.
+/// @param min the minimum length.
+/// @param max the maximum length.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, INVALID if the pattern was never compiled, or
+/// UNSATISFIABLE if the pattern has no output inside the range.
+inline return_code_t generate(std::string &buffer, const length_sampler &sampler, std::size_t min, std::size_t max, uint64_t &seed)
+{
+    buffer.clear();
+    if (sampler.compiled().groups.empty()) {
+        return INVALID;
+    }
+    if (max > sampler.max_length()) {
+        max = sampler.max_length();
+    }
+    double total = 0;
+    for (std::size_t l = min; l <= max; ++l) {
+        total += sampler.count(l);
+    }
+    if (!(total > 0.)) {
+        return UNSATISFIABLE;
+    }
+    double value       = length_sampler::draw(seed, total);
+    std::size_t length = min;
+    for (std::size_t l = min; l <= max; ++l) {
+        if (sampler.count(l) > 0.) {
+            length = l;
+            if ((value -= sampler.count(l)) < 0.) {
+                break;
+            }
+        }
+    }
+    std::size_t location = 0;
+    bool capitalize      = false;
+    sampler.render_group(0, length, buffer, location, capitalize, seed);
+    buffer.resize(location);
+    return SUCCESS;
+}
+
+} // namespace namegen
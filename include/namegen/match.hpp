@@ -0,0 +1,203 @@
+/// @file match.hpp
+/// @brief Checking whether a string is a name a pattern can generate.
+/// @details
+/// The automaton of a pattern is determinized with the subset construction,
+/// and then minimized by partition refinement. The resulting dfa checks a
+/// string in a single pass, one table lookup per byte. Capitalization is part
+/// of the automaton: "!s" matches "Mor" but not "mor".
+///
+/// Every check also takes a pointer and a length, so that names held in other
+/// buffers, like the ones of an arena or a std::string_view, are checked
+/// without a copy.
+
+#pragma once
+
+#include "namegen/automaton.hpp"
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Adds to a set of states all the ones reachable through epsilon edges.
+/// @param names the automaton.
+/// @param states the set, which is sorted on return.
+inline void epsilon_closure(const automaton &names, std::vector<uint32_t> &states)
+{
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        for (const automaton::edge *e = names.begin(states[i]); e != names.end(states[i]); ++e) {
+            if ((e->symbol == automaton::epsilon) &&
+                (std::find(states.begin(), states.end(), e->target) == states.end())) {
+                states.push_back(e->target);
+            }
+        }
+    }
+    std::sort(states.begin(), states.end());
+}
+
+/// @brief Merges the equivalent states of a deterministic automaton.
+/// @param table the 256 transitions of each state.
+/// @param accepting the accepting states.
+/// @param symbols the bytes on which some state does not go to the dead one.
+/// @return the minimized automaton.
+inline dfa minimize(const std::vector<uint32_t> &table, const std::vector<bool> &accepting, const std::vector<unsigned char> &symbols)
+{
+    std::size_t states = accepting.size();
+    std::vector<uint32_t> block(states), next(states);
+    for (std::size_t s = 0; s < states; ++s) {
+        block[s] = accepting[s] ? 1 : 0;
+    }
+    // Split blocks until states in the same block agree on every transition.
+    for (std::size_t blocks = 0;;) {
+        std::map<std::vector<uint32_t>, uint32_t> signatures;
+        std::vector<uint32_t> signature(symbols.size() + 1);
+        // The initial state always ends up in block 0.
+        for (std::size_t i = 0; i < states; ++i) {
+            signature[0] = block[i];
+            for (std::size_t k = 0; k < symbols.size(); ++k) {
+                signature[k + 1] = block[table[i * 256 + symbols[k]]];
+            }
+            next[i] = signatures.insert(std::make_pair(signature, static_cast<uint32_t>(signatures.size()))).first->second;
+        }
+        block.swap(next);
+        if (signatures.size() == blocks) {
+            break;
+        }
+        blocks = signatures.size();
+    }
+    std::size_t blocks = *std::max_element(block.begin(), block.end()) + 1;
+    std::vector<uint32_t> minimal(blocks * 256);
+    std::vector<bool> final_blocks(blocks);
+    for (std::size_t s = 0; s < states; ++s) {
+        final_blocks[block[s]] = accepting[s];
+        for (std::size_t c = 0; c < 256; ++c) {
+            minimal[block[s] * 256 + c] = block[table[s * 256 + c]];
+        }
+    }
+    return dfa(minimal, final_blocks);
+}
+
+} // namespace detail
+
+/// @brief Builds the minimal deterministic automaton accepting the same
+/// strings as a pattern automaton.
+/// @param names the automaton of the pattern.
+/// @return the deterministic automaton.
+inline dfa determinize(const automaton &names)
+{
+    // State 0 is the initial one, state 1 is the dead one.
+    std::map<std::vector<uint32_t>, uint32_t> index;
+    std::vector<std::vector<uint32_t> > sets(2);
+    sets[0].push_back(names.start());
+    detail::epsilon_closure(names, sets[0]);
+    index[sets[0]] = 0;
+    index[sets[1]] = 1;
+    std::vector<uint32_t> table;
+    std::vector<bool> accepting;
+    std::vector<bool> used(256, false);
+    for (std::size_t s = 0; s < sets.size(); ++s) {
+        std::map<int, std::vector<uint32_t> > moves;
+        for (std::size_t i = 0; i < sets[s].size(); ++i) {
+            for (const automaton::edge *e = names.begin(sets[s][i]); e != names.end(sets[s][i]); ++e) {
+                if (e->symbol != automaton::epsilon) {
+                    moves[e->symbol].push_back(e->target);
+                }
+            }
+        }
+        accepting.push_back(std::binary_search(sets[s].begin(), sets[s].end(), names.final_state()));
+        table.resize(table.size() + 256, 1);
+        for (std::map<int, std::vector<uint32_t> >::iterator it = moves.begin(); it != moves.end(); ++it) {
+            detail::epsilon_closure(names, it->second);
+            std::map<std::vector<uint32_t>, uint32_t>::iterator found = index.find(it->second);
+            if (found == index.end()) {
+                found = index.insert(std::make_pair(it->second, static_cast<uint32_t>(sets.size()))).first;
+                sets.push_back(it->second);
+            }
+            table[s * 256 + static_cast<std::size_t>(it->first)] = found->second;
+            used[static_cast<std::size_t>(it->first)] = true;
+        }
+        std::vector<uint32_t>().swap(sets[s]);
+    }
+    std::vector<unsigned char> symbols;
+    for (std::size_t c = 0; c < 256; ++c) {
+        if (used[c]) {
+            symbols.push_back(static_cast<unsigned char>(c));
+        }
+    }
+    return detail::minimize(table, accepting, symbols);
+}
+
+/// @brief Checks strings against a pattern in linear time.
+class matcher {
+public:
+    /// @brief Builds the minimal automaton of the pattern.
+    /// @param compiled the compiled pattern, which must not be empty.
+    explicit matcher(const pattern &compiled)
+        : m_language(determinize(automaton(compiled)))
+    {
+    }
+
+    /// @brief Returns the minimal deterministic automaton of the pattern.
+    const dfa &language() const
+    {
+        return m_language;
+    }
+
+    /// @brief Returns true if the pattern can generate the name.
+    bool matches(const std::string &name) const
+    {
+        return m_language.matches(name);
+    }
+
+    /// @brief Returns true if the pattern can generate the name.
+    /// @param name the characters of the name.
+    /// @param length the number of characters.
+    bool matches(const char *name, std::size_t length) const
+    {
+        return m_language.matches(name, length);
+    }
+
+private:
+    /// The minimal deterministic automaton of the pattern.
+    dfa m_language;
+};
+
+/// @brief Checks if a pattern can generate a name. Building the automaton
+/// dominates the cost, use a matcher to check several names.
+/// @param compiled the compiled pattern.
+/// @param name the name.
+/// @return true if the pattern can generate the name.
+inline bool matches(const pattern &compiled, const std::string &name)
+{
+    return !compiled.groups.empty() && matcher(compiled).matches(name);
+}
+
+/// @brief Checks if a pattern can generate a name, like matches() above.
+/// @param compiled the compiled pattern.
+/// @param name the characters of the name.
+/// @param length the number of characters.
+/// @return true if the pattern can generate the name.
+inline bool matches(const pattern &compiled, const char *name, std::size_t length)
+{
+    return !compiled.groups.empty() && matcher(compiled).matches(name, length);
+}
+
+/// @brief Checks many names against many patterns.
+/// @param results for each name, one entry per pattern: results[n * matchers.size() + p]
+/// is true if pattern p can generate name n.
+/// @param matchers the patterns.
+/// @param names the names.
+inline void matches(std::vector<bool> &results, const std::vector<matcher> &matchers, const std::vector<std::string> &names)
+{
+    results.assign(names.size() * matchers.size(), false);
+    // One automaton at a time, so that its table stays in cache.
+    for (std::size_t p = 0; p < matchers.size(); ++p) {
+        for (std::size_t n = 0; n < names.size(); ++n) {
+            results[n * matchers.size() + p] = matchers[p].matches(names[n]);
+        }
+    }
+}
+
+} // namespace namegen
@@ -0,0 +1,329 @@
+/// @file name_pool.hpp
+/// @brief Names generated ahead of time by a background thread.
+/// @details
+/// Generating on the request path costs an unpredictable amount of time: long
+/// paths of the pattern, and strings that have to grow. A name_pool moves that
+/// cost to a background thread, which keeps a lock-free ring of names per
+/// pattern topped up with arena batches. Callers pop names through a per-thread
+/// cache, which takes several names from the ring at once and reuses their
+/// strings, so that a pop is mostly a swap of two strings.
+///
+/// When a ring runs dry the caller generates the name itself, with the seed its
+/// cache keeps for the pattern, and the pool counts the event as a starvation.
+/// Both use the engine of the pattern, so a pattern set to ENGINE_TABLE draws
+/// other names for the same seeds than with the engine chosen by compile()
+/// (see engine.hpp).
+
+#pragma once
+
+#include "namegen/queue.hpp"
+#include "namegen/shared_generator.hpp"
+
+#include <chrono>
+#include <deque>
+#include <thread>
+
+namespace namegen
+{
+
+/// @brief Per-pattern buffers of names, refilled by a background thread.
+class name_pool {
+public:
+    /// @brief The counters of the pool.
+    struct statistics {
+        /// The number of batches generated by the background thread.
+        uint64_t refills;
+        /// The number of names generated by the background thread.
+        uint64_t generated;
+        /// The number of names taken from the rings.
+        uint64_t popped;
+        /// The number of names generated by callers, because a ring was empty.
+        uint64_t starved;
+        /// The number of names dropped by the background thread, because they
+        /// were too long for the rings.
+        uint64_t dropped;
+        /// The names generated by the background thread per second, since the
+        /// pool started.
+        double refill_rate;
+    };
+
+    /// @brief The names a thread has taken from the rings, but not used yet.
+    /// @details A cache must be used by a single thread at a time.
+    class cache {
+    public:
+        /// @brief Creates an empty cache, with a seed of its own.
+        cache()
+            : m_seed(next_seed()),
+              m_names(),
+              m_count(),
+              m_seeds()
+        {
+        }
+
+        /// @brief Creates an empty cache.
+        /// @param seed the seed from which the cache derives, for each
+        /// pattern, the seed used when the caller must generate a name.
+        explicit cache(uint64_t seed)
+            : m_seed(seed),
+              m_names(),
+              m_count(),
+              m_seeds()
+        {
+        }
+
+    private:
+        friend class name_pool;
+
+        /// @brief Returns a different seed for every cache created without one.
+        static uint64_t next_seed()
+        {
+            static std::atomic<uint64_t> counter(0);
+            return detail::stream_seed(0x9e3779b97f4a7c15ULL, counter.fetch_add(1, std::memory_order_relaxed));
+        }
+
+        /// The seed of the cache.
+        uint64_t m_seed;
+        /// The cached names of each pattern.
+        std::vector<std::vector<std::string> > m_names;
+        /// The number of cached names of each pattern.
+        std::vector<std::size_t> m_count;
+        /// The seed of each pattern, used when the caller must generate a name.
+        std::vector<uint64_t> m_seeds;
+    };
+
+    /// @brief Creates an empty pool.
+    /// @param capacity the number of names buffered for each pattern.
+    /// @param max_length the maximum length of a buffered name, longer ones
+    /// are dropped by the background thread. The callers generate names of any
+    /// length once a ring runs dry.
+    /// @param batch the number of names generated at once, at least 1.
+    /// @param local the number of names a cache takes from a ring at once, at
+    /// least 1.
+    explicit name_pool(std::size_t capacity = 4096, std::size_t max_length = 63, std::size_t batch = 256, std::size_t local = 8)
+        : m_capacity(capacity),
+          m_max_length(max_length),
+          m_batch(batch ? batch : 1),
+          m_local(local ? local : 1),
+          m_slots(),
+          m_running(false),
+          m_thread(),
+          m_start(std::chrono::steady_clock::now().time_since_epoch().count()),
+          m_refills(0),
+          m_generated(0),
+          m_popped(0),
+          m_starved(0),
+          m_dropped(0)
+    {
+    }
+
+    /// @brief Stops the background thread.
+    ~name_pool()
+    {
+        this->stop();
+    }
+
+    /// @brief Adds a pattern, before the pool is started.
+    /// @param compiled the compiled pattern, which must outlive the pool.
+    /// @param seed the seed used by the background thread.
+    /// @return the identifier of the pattern, to pass to pop().
+    std::size_t add(const pattern &compiled, uint64_t seed)
+    {
+        m_slots.push_back(slot());
+        slot &added = m_slots.back();
+        added.compiled = &compiled;
+        added.seed     = seed;
+        added.memory.resize((detail::name_ring::footprint(m_capacity, m_max_length) + 7) / 8);
+        added.ring.create(&added.memory[0], m_capacity, m_max_length);
+        return m_slots.size() - 1;
+    }
+
+    /// @brief Fills all the buffers, and starts the background thread.
+    /// @param interval how long the thread sleeps when all buffers are full.
+    void start(std::chrono::microseconds interval = std::chrono::microseconds(100))
+    {
+        if (m_running.exchange(true)) {
+            return;
+        }
+        m_start.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        this->refill();
+        m_thread = std::thread(&name_pool::run, this, interval);
+    }
+
+    /// @brief Stops the background thread, the buffered names are kept.
+    void stop()
+    {
+        if (m_running.exchange(false)) {
+            m_thread.join();
+        }
+    }
+
+    /// @brief Takes a name of the given pattern.
+    /// @param buffer the string where the name is placed.
+    /// @param id the identifier returned by add().
+    /// @param local the cache of the calling thread.
+    /// @return the outcome of generate(), when the caller had to generate the
+    /// name, SUCCESS otherwise.
+    return_code_t pop(std::string &buffer, std::size_t id, cache &local)
+    {
+        if (local.m_names.size() <= id) {
+            local.m_names.resize(m_slots.size(), std::vector<std::string>(m_local));
+            local.m_count.resize(m_slots.size(), 0);
+            // Every pattern gets its own stream, and so does every cache.
+            for (std::size_t i = local.m_seeds.size(); i < m_slots.size(); ++i) {
+                local.m_seeds.push_back(detail::stream_seed(m_slots[i].seed, local.m_seed));
+            }
+        }
+        std::vector<std::string> &names = local.m_names[id];
+        std::size_t &count              = local.m_count[id];
+        if (count == 0) {
+            while ((count < names.size()) && m_slots[id].ring.pop(names[count])) {
+                ++count;
+            }
+            m_popped.fetch_add(count, std::memory_order_relaxed);
+        }
+        if (count == 0) {
+            m_starved.fetch_add(1, std::memory_order_relaxed);
+            return generate(buffer, *m_slots[id].compiled, local.m_seeds[id]);
+        }
+        // The string of the caller is reused by the next refill of the cache.
+        buffer.swap(names[--count]);
+        return SUCCESS;
+    }
+
+    /// @brief Returns the number of names buffered for a pattern, outside the
+    /// caches.
+    std::size_t size(std::size_t id) const
+    {
+        return m_slots[id].ring.size();
+    }
+
+    /// @brief Returns the counters of the pool.
+    statistics stats() const
+    {
+        statistics result;
+        result.refills   = m_refills.load(std::memory_order_relaxed);
+        result.generated = m_generated.load(std::memory_order_relaxed);
+        result.popped    = m_popped.load(std::memory_order_relaxed);
+        result.starved   = m_starved.load(std::memory_order_relaxed);
+        result.dropped   = m_dropped.load(std::memory_order_relaxed);
+        std::chrono::steady_clock::duration since(m_start.load(std::memory_order_relaxed));
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch() - since).count();
+        result.refill_rate = (elapsed > 0.) ? static_cast<double>(result.generated) / elapsed : 0.;
+        return result;
+    }
+
+private:
+    name_pool(const name_pool &);
+    name_pool &operator=(const name_pool &);
+
+    /// @brief The names of a pattern.
+    struct slot {
+        /// The compiled pattern.
+        const pattern *compiled;
+        /// The seed of the background thread.
+        uint64_t seed;
+        /// The memory of the ring, in words to keep it aligned.
+        std::vector<uint64_t> memory;
+        /// The names.
+        detail::name_ring ring;
+        /// The last batch of names.
+        name_arena arena;
+        /// The next name of the batch to push.
+        std::size_t next;
+
+        slot()
+            : compiled(NULL),
+              seed(0),
+              memory(),
+              ring(),
+              arena(),
+              next(0)
+        {
+        }
+    };
+
+    /// @brief Tops up all the rings.
+    /// @return true if some names were pushed.
+    bool refill()
+    {
+        bool pushed = false;
+        for (std::size_t i = 0; i < m_slots.size(); ++i) {
+            slot &current = m_slots[i];
+            // Leave the ring alone until half of it has been taken.
+            if (current.ring.size() * 2 > current.ring.capacity()) {
+                continue;
+            }
+            // A whole batch of names too long for the ring stops the pattern
+            // until the next call, the next batch would likely be dropped too.
+            bool useful = true;
+            for (;;) {
+                if (current.next == current.arena.size()) {
+                    if (!useful) {
+                        break;
+                    }
+                    current.arena.clear();
+                    current.next = 0;
+                    if (generate(current.arena, *current.compiled, m_batch, current.seed) != SUCCESS) {
+                        break;
+                    }
+                    m_refills.fetch_add(1, std::memory_order_relaxed);
+                    m_generated.fetch_add(m_batch, std::memory_order_relaxed);
+                    useful = false;
+                }
+                std::size_t length = current.arena.length(current.next);
+                if (length > current.ring.max_length()) {
+                    // Too long for the ring, the name is dropped.
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                } else if (current.ring.push(current.arena.name(current.next), length)) {
+                    pushed = true;
+                    useful = true;
+                } else {
+                    // Full, the name waits for the next call.
+                    break;
+                }
+                ++current.next;
+            }
+        }
+        return pushed;
+    }
+
+    /// @brief The loop of the background thread.
+    void run(std::chrono::microseconds interval)
+    {
+        while (m_running.load()) {
+            if (!this->refill()) {
+                std::this_thread::sleep_for(interval);
+            }
+        }
+    }
+
+    /// The number of names buffered for each pattern.
+    std::size_t m_capacity;
+    /// The maximum length of a buffered name.
+    std::size_t m_max_length;
+    /// The number of names generated at once.
+    std::size_t m_batch;
+    /// The number of names a cache takes at once.
+    std::size_t m_local;
+    /// The slots of the patterns, a deque keeps the rings in place.
+    std::deque<slot> m_slots;
+    /// If the background thread is running.
+    std::atomic<bool> m_running;
+    /// The background thread.
+    std::thread m_thread;
+    /// When the pool started, in ticks of the steady clock, read by stats()
+    /// from any thread.
+    std::atomic<std::chrono::steady_clock::rep> m_start;
+    /// The number of batches generated.
+    std::atomic<uint64_t> m_refills;
+    /// The number of names generated by the background thread.
+    std::atomic<uint64_t> m_generated;
+    /// The number of names taken from the rings.
+    std::atomic<uint64_t> m_popped;
+    /// The number of names generated by the callers.
+    std::atomic<uint64_t> m_starved;
+    /// The number of names too long for the rings.
+    std::atomic<uint64_t> m_dropped;
+};
+
+} // namespace namegen
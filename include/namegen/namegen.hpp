@@ -33,9 +33,23 @@
 /// or "bar". The pattern "<c|v|>" emits a constant, vowel, or nothing at
 /// all.
 ///
+/// An alternative of a token group, or of the whole pattern, can be given a
+/// weight by ending it with a colon followed by up to nine digits. For example,
+/// "<s:5|v:1>" emits a syllable five times out of six. Alternatives without a
+/// weight weigh 1. Inside literal groups colons and digits are always emitted,
+/// hence a literal group also escapes a colon that would end an alternative:
+/// "<a|b>(:3)" emits "a:3" or "b:3", while "<a|b>:3" weighs the whole pattern.
+///
+/// Compiled patterns can also take their tokens from user tables, bound to
+/// keys or to names like "$elf_prefix" (see dictionary.hpp).
+///
 /// An exclamation point ! means to capitalize the component that follows
 /// it. For example, "!(foo)" will emit "Foo" and "v!s" will emit a
 /// lowercase vowel followed by a capitalized syllable, like "eRod".
+/// Capitalization does not depend on the locale: it maps the ASCII letters
+/// and, for the tokens of user tables written in UTF-8, the lower case
+/// letters of the Latin, Greek, Cyrillic and Armenian alphabets. Any other
+/// character is emitted as it is.
 ///
 /// This library is based on the RinkWorks Fantasy Name Generator.
 /// http://www.rinkworks.com/namegen/
@@ -44,7 +58,9 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 
 /// @brief Main namespace.
 namespace namegen
@@ -53,11 +69,21 @@ namespace namegen
 /// Cannot exceed bits in a long.
 #define NAME_MAX_DEPTH 32
 
+/// Marks the support functions that can be evaluated at compile time, which
+/// takes the relaxed constexpr rules of C++14.
+#if __cplusplus >= 201402L
+#define NAME_CONSTEXPR constexpr
+#else
+#define NAME_CONSTEXPR inline
+#endif
+
 /// Return codes.
 enum return_code_t {
-    SUCCESS, ///< Name successfully generated.
-    INVALID, ///< Pattern is invalid.
-    TOO_DEEP ///< Pattern exceeds maximum nesting depth.
+    SUCCESS,      ///< Name successfully generated.
+    INVALID,      ///< Pattern is invalid.
+    TOO_DEEP,     ///< Pattern exceeds maximum nesting depth.
+    TOO_LONG,     ///< Encoded name exceeds NAME_ENCODED_CAPACITY bytes.
+    UNSATISFIABLE ///< No name of the pattern satisfies the constraints.
 };
 
 /// Rather than compile the pattern into some internal representation,
@@ -75,126 +101,170 @@ enum return_code_t {
 namespace detail
 {
 
+/// @brief The built-in token tables, usable in constant expressions.
+/// @details A class template, so that its static arrays can be defined inside
+/// a header.
+template <typename T = void>
+struct builtin_tokens {
+    /// Generic syllables.
+    static constexpr const char *const s[] = {
+        "ach", "ack", "ad", "age", "ald", "ale", "an", "ang", "ar", "ard",
+        "as", "ash", "at", "ath", "augh", "aw", "ban", "bel", "bur", "cer",
+        "cha", "che", "dan", "dar", "del", "den", "dra", "dyn", "ech", "eld",
+        "elm", "em", "en", "end", "eng", "enth", "er", "ess", "est", "et",
+        "gar", "gha", "hat", "hin", "hon", "ia", "ight", "ild", "im", "ina",
+        "ine", "ing", "ir", "is", "iss", "it", "kal", "kel", "kim", "kin",
+        "ler", "lor", "lye", "mor", "mos", "nal", "ny", "nys", "old", "om",
+        "on", "or", "orm", "os", "ough", "per", "pol", "qua", "que", "rad",
+        "rak", "ran", "ray", "ril", "ris", "rod", "roth", "ryn", "sam",
+        "say", "ser", "shy", "skel", "sul", "tai", "tan", "tas", "ther",
+        "tia", "tin", "ton", "tor", "tur", "um", "und", "unt", "urn", "usk",
+        "ust", "ver", "ves", "vor", "war", "wor", "yer"
+    };
+    /// Vowels.
+    static constexpr const char *const v[] = {
+        "a", "e", "i", "o", "u", "y"
+    };
+    /// Vowels and vowel combinations.
+    static constexpr const char *const V[] = {
+        "a", "e", "i", "o", "u", "y", "ae", "ai", "au", "ay", "ea", "ee",
+        "ei", "eu", "ey", "ia", "ie", "oe", "oi", "oo", "ou", "ui"
+    };
+    /// Consonants.
+    static constexpr const char *const c[] = {
+        "b", "c", "d", "f", "g", "h", "j", "k", "l", "m", "n", "p", "q", "r",
+        "s", "t", "v", "w", "x", "y", "z"
+    };
+    /// Consonants and combinations suitable for beginning a word.
+    static constexpr const char *const B[] = {
+        "b", "bl", "br", "c", "ch", "chr", "cl", "cr", "d", "dr", "f", "g",
+        "h", "j", "k", "l", "ll", "m", "n", "p", "ph", "qu", "r", "rh", "s",
+        "sch", "sh", "sl", "sm", "sn", "st", "str", "sw", "t", "th", "thr",
+        "tr", "v", "w", "wh", "y", "z", "zh"
+    };
+    /// Consonants and combinations suitable anywhere in a word.
+    static constexpr const char *const C[] = {
+        "b", "c", "ch", "ck", "d", "f", "g", "gh", "h", "k", "l", "ld", "ll",
+        "lt", "m", "n", "nd", "nn", "nt", "p", "ph", "q", "r", "rd", "rr",
+        "rt", "s", "sh", "ss", "st", "t", "th", "v", "w", "y", "z"
+    };
+    /// Insults.
+    static constexpr const char *const i[] = {
+        "air", "ankle", "ball", "beef", "bone", "bum", "bumble", "bump",
+        "cheese", "clod", "clot", "clown", "corn", "dip", "dolt", "doof",
+        "dork", "dumb", "face", "finger", "foot", "fumble", "goof",
+        "grumble", "head", "knock", "knocker", "knuckle", "loaf", "lump",
+        "lunk", "meat", "muck", "munch", "nit", "numb", "pin", "puff",
+        "skull", "snark", "sneeze", "thimble", "twerp", "twit", "wad",
+        "wimp", "wipe"
+    };
+    /// Mushy names.
+    static constexpr const char *const m[] = {
+        "baby", "booble", "bunker", "cuddle", "cuddly", "cutie", "doodle",
+        "foofie", "gooble", "honey", "kissie", "lover", "lovey", "moofie",
+        "mooglie", "moopie", "moopsie", "nookum", "poochie", "poof",
+        "poofie", "pookie", "schmoopie", "schnoogle", "schnookie",
+        "schnookum", "smooch", "smoochie", "smoosh", "snoogle", "snoogy",
+        "snookie", "snookum", "snuggy", "sweetie", "woogle", "woogy",
+        "wookie", "wookum", "wuddle", "wuddly", "wuggy", "wunny"
+    };
+    /// Mushy name endings.
+    static constexpr const char *const M[] = {
+        "boo", "bunch", "bunny", "cake", "cakes", "cute", "darling",
+        "dumpling", "dumplings", "face", "foof", "goo", "head", "kin",
+        "kins", "lips", "love", "mush", "pie", "poo", "pooh", "pook", "pums"
+    };
+    /// Consonants suited for a stupid person's name.
+    static constexpr const char *const D[] = {
+        "b", "bl", "br", "cl", "d", "f", "fl", "fr", "g", "gh", "gl", "gr",
+        "h", "j", "k", "kl", "m", "n", "p", "th", "w"
+    };
+    /// Syllables suited for a stupid person's name (begin with a vowel).
+    static constexpr const char *const d[] = {
+        "elch", "idiot", "ob", "og", "ok", "olph", "olt", "omph", "ong",
+        "onk", "oo", "oob", "oof", "oog", "ook", "ooz", "org", "ork", "orm",
+        "oron", "ub", "uck", "ug", "ulf", "ult", "um", "umb", "ump", "umph",
+        "un", "unb", "ung", "unk", "unph", "unt", "uzz"
+    };
+};
+
+// Definitions of the arrays, implicit since C++17.
+#if __cplusplus < 201703L
+template <typename T>
+constexpr const char *const builtin_tokens<T>::s[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::v[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::V[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::c[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::B[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::C[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::i[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::m[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::M[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::D[];
+template <typename T>
+constexpr const char *const builtin_tokens<T>::d[];
+#endif
+
 /// @brief If the provided key is valid, it will set `tokens` with the array of
 /// strings, and return the dimension of the array.
 /// @param key the key we want to search.
 /// @param tokens the output argument, if the key is valid it points to an array
 /// of strings, otherwise it is set to NULL.
 /// @return the number of tokens in the array.
-inline std::size_t get_tokens(int key, const char **&tokens)
+inline std::size_t get_tokens(int key, const char *const *&tokens)
 {
     if (key == 's') {
-        static const char *__tokens[] = {
-            "ach", "ack", "ad", "age", "ald", "ale", "an", "ang", "ar", "ard",
-            "as", "ash", "at", "ath", "augh", "aw", "ban", "bel", "bur", "cer",
-            "cha", "che", "dan", "dar", "del", "den", "dra", "dyn", "ech", "eld",
-            "elm", "em", "en", "end", "eng", "enth", "er", "ess", "est", "et",
-            "gar", "gha", "hat", "hin", "hon", "ia", "ight", "ild", "im", "ina",
-            "ine", "ing", "ir", "is", "iss", "it", "kal", "kel", "kim", "kin",
-            "ler", "lor", "lye", "mor", "mos", "nal", "ny", "nys", "old", "om",
-            "on", "or", "orm", "os", "ough", "per", "pol", "qua", "que", "rad",
-            "rak", "ran", "ray", "ril", "ris", "rod", "roth", "ryn", "sam",
-            "say", "ser", "shy", "skel", "sul", "tai", "tan", "tas", "ther",
-            "tia", "tin", "ton", "tor", "tur", "um", "und", "unt", "urn", "usk",
-            "ust", "ver", "ves", "vor", "war", "wor", "yer"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::s;
+        return sizeof(builtin_tokens<>::s) / sizeof(builtin_tokens<>::s[0]);
     }
     if (key == 'v') {
-        static const char *__tokens[] = {
-            "a", "e", "i", "o", "u", "y"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::v;
+        return sizeof(builtin_tokens<>::v) / sizeof(builtin_tokens<>::v[0]);
     }
     if (key == 'V') {
-        static const char *__tokens[] = {
-            "a", "e", "i", "o", "u", "y", "ae", "ai", "au", "ay", "ea", "ee",
-            "ei", "eu", "ey", "ia", "ie", "oe", "oi", "oo", "ou", "ui"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::V;
+        return sizeof(builtin_tokens<>::V) / sizeof(builtin_tokens<>::V[0]);
     }
     if (key == 'c') {
-        static const char *__tokens[] = {
-            "b", "c", "d", "f", "g", "h", "j", "k", "l", "m", "n", "p", "q", "r",
-            "s", "t", "v", "w", "x", "y", "z"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::c;
+        return sizeof(builtin_tokens<>::c) / sizeof(builtin_tokens<>::c[0]);
     }
     if (key == 'B') {
-        static const char *__tokens[] = {
-            "b", "bl", "br", "c", "ch", "chr", "cl", "cr", "d", "dr", "f", "g",
-            "h", "j", "k", "l", "ll", "m", "n", "p", "ph", "qu", "r", "rh", "s",
-            "sch", "sh", "sl", "sm", "sn", "st", "str", "sw", "t", "th", "thr",
-            "tr", "v", "w", "wh", "y", "z", "zh"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::B;
+        return sizeof(builtin_tokens<>::B) / sizeof(builtin_tokens<>::B[0]);
     }
     if (key == 'C') {
-        static const char *__tokens[] = {
-            "b", "c", "ch", "ck", "d", "f", "g", "gh", "h", "k", "l", "ld", "ll",
-            "lt", "m", "n", "nd", "nn", "nt", "p", "ph", "q", "r", "rd", "rr",
-            "rt", "s", "sh", "ss", "st", "t", "th", "v", "w", "y", "z"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::C;
+        return sizeof(builtin_tokens<>::C) / sizeof(builtin_tokens<>::C[0]);
     }
     if (key == 'i') {
-        static const char *__tokens[] = {
-            "air", "ankle", "ball", "beef", "bone", "bum", "bumble", "bump",
-            "cheese", "clod", "clot", "clown", "corn", "dip", "dolt", "doof",
-            "dork", "dumb", "face", "finger", "foot", "fumble", "goof",
-            "grumble", "head", "knock", "knocker", "knuckle", "loaf", "lump",
-            "lunk", "meat", "muck", "munch", "nit", "numb", "pin", "puff",
-            "skull", "snark", "sneeze", "thimble", "twerp", "twit", "wad",
-            "wimp", "wipe"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::i;
+        return sizeof(builtin_tokens<>::i) / sizeof(builtin_tokens<>::i[0]);
     }
     if (key == 'm') {
-        static const char *__tokens[] = {
-            "baby", "booble", "bunker", "cuddle", "cuddly", "cutie", "doodle",
-            "foofie", "gooble", "honey", "kissie", "lover", "lovey", "moofie",
-            "mooglie", "moopie", "moopsie", "nookum", "poochie", "poof",
-            "poofie", "pookie", "schmoopie", "schnoogle", "schnookie",
-            "schnookum", "smooch", "smoochie", "smoosh", "snoogle", "snoogy",
-            "snookie", "snookum", "snuggy", "sweetie", "woogle", "woogy",
-            "wookie", "wookum", "wuddle", "wuddly", "wuggy", "wunny"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::m;
+        return sizeof(builtin_tokens<>::m) / sizeof(builtin_tokens<>::m[0]);
     }
     if (key == 'M') {
-        static const char *__tokens[] = {
-            "boo", "bunch", "bunny", "cake", "cakes", "cute", "darling",
-            "dumpling", "dumplings", "face", "foof", "goo", "head", "kin",
-            "kins", "lips", "love", "mush", "pie", "poo", "pooh", "pook", "pums"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::M;
+        return sizeof(builtin_tokens<>::M) / sizeof(builtin_tokens<>::M[0]);
     }
     if (key == 'D') {
-        static const char *__tokens[] = {
-            "b", "bl", "br", "cl", "d", "f", "fl", "fr", "g", "gh", "gl", "gr",
-            "h", "j", "k", "kl", "m", "n", "p", "th", "w"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::D;
+        return sizeof(builtin_tokens<>::D) / sizeof(builtin_tokens<>::D[0]);
     }
     if (key == 'd') {
-        static const char *__tokens[] = {
-            "elch", "idiot", "ob", "og", "ok", "olph", "olt", "omph", "ong",
-            "onk", "oo", "oob", "oof", "oog", "ook", "ooz", "org", "ork", "orm",
-            "oron", "ub", "uck", "ug", "ulf", "ult", "um", "umb", "ump", "umph",
-            "un", "unb", "ung", "unk", "unph", "unt", "uzz"
-        };
-        tokens = __tokens;
-        return sizeof(__tokens) / sizeof(__tokens[0]);
+        tokens = builtin_tokens<>::d;
+        return sizeof(builtin_tokens<>::d) / sizeof(builtin_tokens<>::d[0]);
     }
     tokens = NULL;
     return 0;
@@ -203,7 +273,7 @@ inline std::size_t get_tokens(int key, const char **&tokens)
 /// @brief Returns a random number.
 /// @param seed the seed used to generate the random number, it is modified.
 /// @return a random number between 0 and ULONG_MAX.
-inline uint64_t get_rand(uint64_t &seed)
+NAME_CONSTEXPR uint64_t get_rand(uint64_t &seed)
 {
     seed ^= seed << 13;
     seed ^= (seed & 0xffffffffUL) >> 17;
@@ -217,18 +287,100 @@ inline uint64_t get_rand(uint64_t &seed)
 /// @param max the upper bound for the random number.
 /// @return a random number between min and max.
 template <typename T>
-inline T get_rand(uint64_t &seed, T min, T max)
+NAME_CONSTEXPR T get_rand(uint64_t &seed, T min, T max)
 {
     return static_cast<T>(min + (get_rand(seed) % max));
 }
 
-/// @brief Capitalizes the given character.
+/// @brief Capitalizes the given character, if it is an ASCII letter, as
+/// std::toupper() does in the "C" locale.
 /// @param c the input caracter
 /// @param capitalize controls if we should capitalize or not.
 /// @return the capitalized character, if capitalize is true.
-inline char get_capitalized(int c, bool capitalize)
+NAME_CONSTEXPR char get_capitalized(int c, bool capitalize)
 {
-    return static_cast<char>(capitalize ? std::toupper(c) : c);
+    return static_cast<char>(c - ((capitalize && (c >= 'a') && (c <= 'z')) ? ('a' - 'A') : 0));
+}
+
+/// @brief Returns the upper case of a code point encoded with two bytes in
+/// UTF-8, which is encoded with two bytes too.
+/// @param code the code point, between 0x80 and 0x7ff.
+/// @return the upper case code point, or the same one if it has none.
+inline unsigned get_upper_code_point(unsigned code)
+{
+    // Latin-1 Supplement, but the division sign.
+    if ((code >= 0xe0) && (code <= 0xfe) && (code != 0xf7)) {
+        return code - 0x20;
+    }
+    if (code == 0xff) {
+        return 0x178;
+    }
+    // Latin Extended-A, pairs of upper and lower case letters.
+    if (((code >= 0x100) && (code <= 0x12f)) || ((code >= 0x132) && (code <= 0x137)) || ((code >= 0x14a) && (code <= 0x177))) {
+        return code & ~1U;
+    }
+    if (((code >= 0x139) && (code <= 0x148)) || ((code >= 0x179) && (code <= 0x17e))) {
+        return (code & 1U) ? code : code - 1;
+    }
+    // Greek, with the accented vowels and the final sigma.
+    if (code == 0x3ac) {
+        return 0x386;
+    }
+    if ((code >= 0x3ad) && (code <= 0x3af)) {
+        return code - 0x25;
+    }
+    if (code == 0x3c2) {
+        return 0x3a3;
+    }
+    if ((code >= 0x3b1) && (code <= 0x3cb)) {
+        return code - 0x20;
+    }
+    if (code == 0x3cc) {
+        return 0x38c;
+    }
+    if ((code == 0x3cd) || (code == 0x3ce)) {
+        return code - 0x3f;
+    }
+    // Cyrillic.
+    if ((code >= 0x430) && (code <= 0x44f)) {
+        return code - 0x20;
+    }
+    if ((code >= 0x450) && (code <= 0x45f)) {
+        return code - 0x50;
+    }
+    if (((code >= 0x460) && (code <= 0x481)) || ((code >= 0x48a) && (code <= 0x4bf))) {
+        return code & ~1U;
+    }
+    // Armenian.
+    if ((code >= 0x561) && (code <= 0x586)) {
+        return code - 0x30;
+    }
+    return code;
+}
+
+/// @brief Capitalizes the first character of a token, in place. An ASCII
+/// letter is handled right away, a letter encoded with two bytes in UTF-8 is
+/// replaced by its upper case, which takes two bytes as well, and any other
+/// character is left as it is.
+/// @param token the token.
+/// @param length the length of the token.
+inline void capitalize_token(char *token, std::size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    unsigned lead = static_cast<unsigned char>(token[0]);
+    if (lead < 0x80) {
+        token[0] = get_capitalized(static_cast<int>(lead), true);
+        return;
+    }
+    unsigned next = (length > 1) ? static_cast<unsigned char>(token[1]) : 0;
+    if (((lead & 0xe0) != 0xc0) || ((next & 0xc0) != 0x80)) {
+        return;
+    }
+    unsigned code = get_upper_code_point(((lead & 0x1fU) << 6) | (next & 0x3fU));
+    token[0]      = static_cast<char>(0xc0 | (code >> 6));
+    token[1]      = static_cast<char>(0x80 | (code & 0x3f));
 }
 
 /// @brief Returns the lenght of the input string.
@@ -241,6 +393,158 @@ inline size_t get_strlen(const char *s)
     return len;
 }
 
+/// @brief Returns the length of the weight starting at the given position.
+/// @param pattern the pattern.
+/// @param position the position of the colon.
+/// @return the length of the weight, colon included, or 0 if the position
+/// does not hold a weight: a colon followed by one to nine digits, which ends
+/// an alternative. The caller checks that the alternative belongs to a token
+/// group, since inside literal groups there are no weights.
+inline std::size_t get_weight_length(const std::string &pattern, std::size_t position)
+{
+    if ((position >= pattern.size()) || (pattern[position] != ':')) {
+        return 0;
+    }
+    std::size_t end = position + 1;
+    while ((end < pattern.size()) && (pattern[end] >= '0') && (pattern[end] <= '9')) {
+        ++end;
+    }
+    if ((end == position + 1) || (end > position + 10)) {
+        return 0;
+    }
+    if ((end < pattern.size()) && (pattern[end] != '|') && (pattern[end] != '>') && (pattern[end] != ')')) {
+        return 0;
+    }
+    return end - position;
+}
+
+/// @brief Returns the weight of an alternative.
+/// @param pattern the pattern.
+/// @param first the first character of the alternative.
+/// @param end the character that ends the alternative, or the end of the
+/// pattern.
+/// @return the weight of the alternative, 1 if it has none.
+inline uint64_t get_weight(const std::string &pattern, std::size_t first, std::size_t end)
+{
+    // Look for the weight right before the end.
+    std::size_t colon = end;
+    while ((colon > first) && (pattern[colon - 1] >= '0') && (pattern[colon - 1] <= '9')) {
+        --colon;
+    }
+    if ((colon == first) || (get_weight_length(pattern, colon - 1) != end - colon + 1)) {
+        return 1;
+    }
+    uint64_t weight = 0;
+    for (std::size_t i = colon; i < end; ++i) {
+        weight = weight * 10 + static_cast<uint64_t>(pattern[i] - '0');
+    }
+    return weight;
+}
+
+/// @brief Computes the weights of all the alternatives of a pattern, in a
+/// single pass.
+/// @param pattern the pattern.
+/// @param weights receives the weight of each alternative, in the order they
+/// start: the first one of the pattern, then one after each `<`, `(` and `|`,
+/// hence at most one more than the characters of the pattern. The
+/// alternatives of literal groups weigh 1.
+inline void get_weights(const std::string &pattern, uint64_t *weights)
+{
+    // The open alternatives: their index, their first character, and if they
+    // belong to a literal group. Deeper ones are only counted, the generator
+    // stops before reaching them.
+    std::size_t index[NAME_MAX_DEPTH];
+    std::size_t first[NAME_MAX_DEPTH];
+    bool literal[NAME_MAX_DEPTH];
+    std::size_t depth = 0, count = 1;
+    index[0]   = 0;
+    first[0]   = 0;
+    literal[0] = false;
+    weights[0] = 1;
+    for (std::size_t position = 0;; ++position) {
+        bool end = position == pattern.size();
+        char c   = end ? '\0' : pattern[position];
+        if ((c == '<') || (c == '(')) {
+            if (++depth < NAME_MAX_DEPTH) {
+                index[depth]   = count;
+                first[depth]   = position + 1;
+                literal[depth] = c == '(';
+            }
+            weights[count++] = 1;
+            continue;
+        }
+        if (!end && (c != '|') && (c != '>') && (c != ')')) {
+            continue;
+        }
+        if (end) {
+            // The end of the pattern ends all the open alternatives, which
+            // the generator reports as invalid after generating them.
+            for (std::size_t i = 0; (i <= depth) && (i < NAME_MAX_DEPTH); ++i) {
+                if (!literal[i]) {
+                    weights[index[i]] = get_weight(pattern, first[i], position);
+                }
+            }
+            break;
+        }
+        // The character ends the innermost open alternative.
+        if ((depth < NAME_MAX_DEPTH) && !literal[depth]) {
+            weights[index[depth]] = get_weight(pattern, first[depth], position);
+        }
+        if (c == '|') {
+            if (depth < NAME_MAX_DEPTH) {
+                index[depth] = count;
+                first[depth] = position + 1;
+            }
+            weights[count++] = 1;
+        } else if (depth-- == 0) {
+            // Unbalanced, the generator stops here.
+            break;
+        }
+    }
+}
+
+/// @brief Returns the threshold below which a random number switches the
+/// selection to a new alternative (weighted reservoir sampling). Without
+/// weights, the n-th alternative gets the threshold 0xffffffff / n.
+/// @param weight the weight of the new alternative.
+/// @param total the total weight of the alternatives seen so far, the new one
+/// included.
+/// @return the threshold.
+NAME_CONSTEXPR uint64_t get_threshold(uint64_t weight, uint64_t total)
+{
+    if (weight == total) {
+        // All the previous alternatives weigh nothing.
+        return total ? 0x100000000ULL : 0;
+    }
+    return (0xffffffffULL * weight) / total;
+}
+
+/// @brief Checks if the character has a meaning inside a pattern, and ends a
+/// run of literals.
+/// @param c the character.
+/// @return true if the character is special.
+inline bool is_special(char c)
+{
+    return (c == '<') || (c == '>') || (c == '(') || (c == ')') || (c == '|') || (c == '!') || (c == ':');
+}
+
+/// @brief Copies a run of characters inside the buffer, at the given location.
+/// @param buffer the buffer we manipulate.
+/// @param location the location where the run should be placed.
+/// @param run the characters.
+/// @param size the number of characters.
+/// @return where the run was copied.
+inline char *insert_run(std::string &buffer, std::size_t &location, const char *run, std::size_t size)
+{
+    if ((location + size) > buffer.size()) {
+        buffer.resize(location + size);
+    }
+    char *result = &buffer[0] + location;
+    std::memcpy(result, run, size);
+    location += size;
+    return result;
+}
+
 /// @brief Copy a random token inside the buffer, based on the key, at the given location.
 /// @param buffer the buffer we manipulate.
 /// @param location the location where the substitution should be placed.
@@ -254,23 +558,18 @@ inline void insert_token(
     uint64_t &seed,
     bool capitalize)
 {
-    const char **tokens;
+    const char *const *tokens;
     std::size_t count = get_tokens(key, tokens);
     if (count <= 0) {
-        if (location == buffer.size()) {
-            buffer.resize(buffer.size() + 1);
-        }
-        buffer[location++] = detail::get_capitalized(key, capitalize);
+        char value = get_capitalized(key, capitalize);
+        insert_run(buffer, location, &value, 1);
     } else {
         size_t select     = get_rand<size_t>(seed, 0UL, count);
         const char *token = tokens[select];
         std::size_t size  = get_strlen(token);
-        if ((location + size) > buffer.size()) {
-            buffer.resize(buffer.size() + size);
-        }
-        while (*token) {
-            buffer[location++] = get_capitalized(*token++, capitalize);
-            capitalize         = 0;
+        char *copy        = insert_run(buffer, location, token, size);
+        if (capitalize) {
+            capitalize_token(copy, size);
         }
     }
 }
@@ -284,7 +583,7 @@ inline void insert_token(
 /// @return The return value is one of the above codes, indicating success or
 /// that something went wrong. Truncation occurs when DST was too short. Pattern
 /// is validated even when the output has been truncated.
-return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t &seed)
+inline return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t &seed)
 {
     // Current nesting depth.
     int depth = 0;
@@ -295,8 +594,26 @@ return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t
 
     // Reset pointer (undo generate).
     std::size_t reset[NAME_MAX_DEPTH];
-    // Number of groups.
-    uint64_t n[NAME_MAX_DEPTH];
+    // Total weight of the alternatives seen so far.
+    uint64_t total[NAME_MAX_DEPTH];
+    // Weights can be skipped entirely when the pattern has none.
+    bool weighted = pattern.find(':') != std::string::npos;
+    // Weights of the alternatives, in the order they start, computed once.
+    // Short patterns keep them on the stack.
+    uint64_t local[64];
+    std::vector<uint64_t> allocated;
+    uint64_t *weights = local;
+    if (weighted) {
+        if (pattern.size() >= 64) {
+            allocated.resize(pattern.size() + 1);
+            weights = &allocated[0];
+        }
+        detail::get_weights(pattern, weights);
+    }
+    // Index of the next alternative that starts.
+    std::size_t next = 0;
+    // Weight of the current alternative.
+    uint64_t weight;
     // Actively generating?
     uint64_t silent = 0;
     // Current "mode".
@@ -310,7 +627,7 @@ return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t
     // Contains the currently parsed character.
     unsigned char c;
 
-    n[0]     = 1;
+    total[0] = weighted ? weights[next++] : 1;
     reset[0] = 0;
     for (std::string::const_iterator it = pattern.begin(); it != pattern.end(); ++it) {
         // Get the character.
@@ -323,7 +640,7 @@ return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t
                 return TOO_DEEP;
             }
             bit          = 1UL << depth;
-            n[depth]     = 1;
+            total[depth] = weighted ? weights[next++] : 1;
             reset[depth] = loc;
             literal &= ~bit;
             silent &= ~bit;
@@ -338,7 +655,7 @@ return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t
                 return TOO_DEEP;
             }
             bit          = 1UL << depth;
-            n[depth]     = 1;
+            total[depth] = weighted ? weights[next++] : 1;
             reset[depth] = loc;
             literal |= bit;
             silent &= ~bit;
@@ -372,10 +689,12 @@ return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t
             break;
 
         case '|':
-            bit = 1UL << depth;
+            bit    = 1UL << depth;
+            weight = weighted ? weights[next++] : 1;
+            total[depth] += weight;
             // Stay silent if parent group is silent.
             if (!(silent & (bit >> 1))) {
-                if (detail::get_rand(seed) < (0xffffffffUL / ++n[depth])) {
+                if (detail::get_rand(seed) < detail::get_threshold(weight, total[depth])) {
                     // Switch to this option.
                     loc = reset[depth];
                     silent &= ~bit;
@@ -392,18 +711,31 @@ return_code_t generate(std::string &buffer, const std::string &pattern, uint64_t
             break;
 
         default:
+            if (weighted && (c == ':') && !(literal & (1UL << depth))) {
+                std::size_t length = detail::get_weight_length(pattern, static_cast<std::size_t>(it - pattern.begin()));
+                if (length) {
+                    // Skip the weight, it is not part of the name.
+                    it += static_cast<std::ptrdiff_t>(length - 1);
+                    break;
+                }
+            }
             bit = 1UL << depth;
-            if (!(silent & bit)) {
-                if (literal & bit) {
-                    // Copy value literally.
-                    if (loc == buffer.size()) {
-                        buffer.resize(buffer.size() + 1);
-                    }
-                    buffer[loc++] = detail::get_capitalized(c, capitalize);
-                } else {
-                    // Insert the toke inside the buffer.
-                    detail::insert_token(buffer, loc, c, seed, capitalize);
+            if (literal & bit) {
+                // Copy the whole run of literals, up to the next special
+                // character, at once.
+                std::size_t first = static_cast<std::size_t>(it - pattern.begin());
+                std::size_t last  = first + 1;
+                while ((last < pattern.size()) && !detail::is_special(pattern[last])) {
+                    ++last;
+                }
+                if (!(silent & bit)) {
+                    char *run = detail::insert_run(buffer, loc, pattern.data() + first, last - first);
+                    run[0]    = detail::get_capitalized(run[0], capitalize);
                 }
+                it += static_cast<std::ptrdiff_t>(last - first - 1);
+            } else if (!(silent & bit)) {
+                // Insert the toke inside the buffer.
+                detail::insert_token(buffer, loc, c, seed, capitalize);
             }
             capitalize = false;
         }
@@ -0,0 +1,210 @@
+/// @file parallel.hpp
+/// @brief Parallel generation of the names of a legacy seed stream.
+/// @details
+/// Calling generate() in a loop, with the same seed, gives a sequence of names
+/// where each one starts from the seed the previous one left behind. The
+/// sequence can only be split among threads once the seed at the start of each
+/// chunk is known, and that depends on how many numbers every name draws.
+///
+/// generate_parallel() finds those seeds first, and then lets the threads
+/// generate the chunks at the same time:
+///  - when every name of the pattern draws the same number of random numbers,
+///    the seed of a chunk is the first seed advanced by all the draws of the
+///    names before it, computed with jump(), without touching any name;
+///  - otherwise, a pre-pass replays the choices of the names, drawing the same
+///    numbers but writing nothing, which costs a fraction of the generation.
+///
+/// The names, and the seed left at the end, are exactly the ones of the loop.
+
+#pragma once
+
+#include "namegen/jump.hpp"
+#include "namegen/pattern.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief A value returned when the number of draws is not fixed.
+enum { variable_draws = -1 };
+
+/// @brief Counts the random numbers drawn by a group, if it is always the
+/// same number.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @return the number of draws, or variable_draws.
+inline long fixed_draws(const pattern &compiled, std::size_t index)
+{
+    const pattern::group &group = compiled.groups[index];
+    long result                 = 0;
+    for (std::size_t i = group.first; i < group.last; ++i) {
+        const pattern::alternative &alternative = compiled.alternatives[i];
+        long draws                              = 0;
+        for (std::size_t j = alternative.first; j < alternative.last; ++j) {
+            const pattern::item &item = compiled.items[j];
+            if (item.kind == pattern::ITEM_TOKEN) {
+                ++draws;
+            } else if (item.kind == pattern::ITEM_GROUP) {
+                long nested = fixed_draws(compiled, item.group);
+                if (nested == variable_draws) {
+                    return variable_draws;
+                }
+                draws += nested;
+            }
+        }
+        // The first alternative is always generated, the others draw only
+        // when the reservoir switches to them.
+        if (i == group.first) {
+            result = draws;
+        } else if (draws) {
+            return variable_draws;
+        } else {
+            ++result;
+        }
+    }
+    return result;
+}
+
+/// @brief Draws the random numbers of a group, the way the single-pass
+/// generator does, weights included, without generating anything.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @param seed the seed used for random number generation.
+inline void skip_group(const pattern &compiled, std::size_t index, uint64_t &seed)
+{
+    const pattern::group &group = compiled.groups[index];
+    uint64_t total              = 0;
+    for (std::size_t i = group.first; i < group.last; ++i) {
+        const pattern::alternative &alternative = compiled.alternatives[i];
+        total += alternative.weight;
+        if ((i != group.first) && (get_rand(seed) >= get_threshold(alternative.weight, total))) {
+            continue;
+        }
+        for (std::size_t j = alternative.first; j < alternative.last; ++j) {
+            const pattern::item &item = compiled.items[j];
+            if (item.kind == pattern::ITEM_TOKEN) {
+                item.table->select(seed);
+            } else if (item.kind == pattern::ITEM_GROUP) {
+                skip_group(compiled, item.group, seed);
+            }
+        }
+    }
+}
+
+/// @brief The chunks of names shared by the threads of generate_parallel().
+struct parallel_job {
+    /// Where the names are placed.
+    std::vector<std::string> *names;
+    /// The pattern.
+    const std::string *source;
+    /// The compiled pattern.
+    const pattern *compiled;
+    /// If the compiled tree uses alias tables, and cannot follow the stream.
+    bool weighted;
+    /// The number of names of a chunk.
+    std::size_t size;
+    /// The seed at the start of every chunk.
+    std::vector<uint64_t> seeds;
+    /// The next chunk to generate.
+    std::atomic<std::size_t> next;
+};
+
+/// @brief Generates chunks of names, until none is left.
+/// @param job the chunks.
+inline void run_chunks(parallel_job *job)
+{
+    std::vector<std::string> &names = *job->names;
+    for (std::size_t chunk; (chunk = job->next.fetch_add(1)) < job->seeds.size();) {
+        uint64_t seed    = job->seeds[chunk];
+        std::size_t last = std::min(names.size(), (chunk + 1) * job->size);
+        for (std::size_t i = chunk * job->size; i < last; ++i) {
+            if (job->weighted) {
+                generate(names[i], *job->source, seed);
+                names[i].resize(get_strlen(names[i].c_str()));
+            } else {
+                generate(names[i], *job->compiled, seed);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/// @brief Generates the same names as calling generate() in a loop with the
+/// same seed, using several threads.
+/// @param names where the names are placed, resized to count.
+/// @param source the pattern, using the built-in token tables.
+/// @param count the number of names.
+/// @param seed the seed used for random number generation, left as the loop
+/// would leave it.
+/// @param threads the number of threads, 0 for one per hardware thread.
+/// @return SUCCESS, or the error generate() reports for the pattern, in which
+/// case names is left empty and seed untouched.
+inline return_code_t generate_parallel(
+    std::vector<std::string> &names,
+    const std::string &source,
+    std::size_t count,
+    uint64_t &seed,
+    std::size_t threads = 0)
+{
+    pattern compiled;
+    return_code_t ret = compile(compiled, source);
+    if (ret != SUCCESS) {
+        names.clear();
+        return ret;
+    }
+    // The seeds of the chunks follow the stream of the tree, and of the
+    // bytecode.
+    compiled.engine = pattern::ENGINE_BYTECODE;
+    names.resize(count);
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    // A few chunks per thread even out names of different lengths.
+    std::size_t chunks = std::min(count, threads * 4);
+    if (chunks == 0) {
+        return SUCCESS;
+    }
+    detail::parallel_job job;
+    job.names    = &names;
+    job.source   = &source;
+    job.compiled = &compiled;
+    job.weighted = false;
+    for (std::size_t i = 0; i < compiled.groups.size(); ++i) {
+        job.weighted |= compiled.groups[i].weighted;
+    }
+    job.size = (count + chunks - 1) / chunks;
+    job.seeds.resize((count + job.size - 1) / job.size);
+    job.next.store(0);
+    long draws = detail::fixed_draws(compiled, 0);
+    for (std::size_t i = 0; i < job.seeds.size(); ++i) {
+        job.seeds[i]     = seed;
+        std::size_t size = std::min(job.size, count - i * job.size);
+        if (draws != detail::variable_draws) {
+            jump(seed, static_cast<uint64_t>(draws) * size);
+        } else {
+            while (size--) {
+                detail::skip_group(compiled, 0, seed);
+            }
+        }
+    }
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < std::min(threads, job.seeds.size()); ++i) {
+        workers.push_back(std::thread(detail::run_chunks, &job));
+    }
+    // The calling thread takes its share of the chunks.
+    detail::run_chunks(&job);
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    return SUCCESS;
+}
+
+} // namespace namegen
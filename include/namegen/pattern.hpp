@@ -0,0 +1,1164 @@
+/// @file pattern.hpp
+/// @brief Patterns compiled into a tree of groups, alternatives and items.
+/// @details
+/// The single-pass generate() re-reads the pattern every time it is called,
+/// and never materializes its structure. compile() parses the pattern once
+/// into a tree, which the other facilities of the library walk.
+///
+/// Generating from a compiled pattern consumes random numbers in exactly the
+/// same order as the single-pass generator, hence for the same seed both
+/// produce the same name. Groups with weighted alternatives are the exception:
+/// the single-pass generator still walks them with a (weighted) reservoir,
+/// while the compiled pattern stores an alias table per group, and selects
+/// the alternative with a single draw. Both follow the same distribution, but
+/// not the same stream of random numbers.
+///
+/// Patterns with few outputs, like "<v|V>(dim)", can also be materialized:
+/// every output is stored inside a packed table with its probability, and a
+/// name costs a single draw from an alias table and a copy. The table follows
+/// the same distribution as the tree, but, again, not the same stream of
+/// random numbers, hence compile() neither selects nor builds it: it is
+/// opt-in, through set_engine() from engine.hpp, which builds it on demand,
+/// for code that does not need to reproduce a name from its seed.
+///
+/// The tree is also compiled into bytecode: a dense array of instructions,
+/// where a `!` and the token after it, two tokens in a row, and a run of
+/// literals each take a single instruction, dispatched with computed gotos
+/// where the compiler supports them. The bytecode draws exactly the same
+/// numbers as the tree, and writes the name without growing the buffer one
+/// character at a time.
+
+#pragma once
+
+#include "namegen/alias.hpp"
+#include "namegen/dictionary.hpp"
+#include "namegen/namegen.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
+
+/// Maximum number of derivations of a pattern whose outputs are materialized.
+#define NAME_MATERIALIZE_LIMIT 4096
+
+/// Dispatches the bytecode with computed gotos, where the compiler has them.
+#if defined(__GNUC__)
+#define NAME_THREADED_DISPATCH 1
+#else
+#define NAME_THREADED_DISPATCH 0
+#endif
+
+namespace namegen
+{
+
+/// @brief A pattern compiled into a tree.
+/// @details Group 0 is the root, the implicit token group that wraps the whole
+/// pattern. Each group owns a contiguous range of alternatives, and each
+/// alternative owns a contiguous range of items.
+struct pattern {
+    /// @brief The kinds of item an alternative is made of.
+    enum item_kind_t {
+        ITEM_TOKEN,      ///< A random token taken from a table.
+        ITEM_LITERAL,    ///< A character emitted literally.
+        ITEM_CAPITALIZE, ///< A `!`, which capitalizes the next component.
+        ITEM_GROUP       ///< A nested group.
+    };
+
+    /// @brief How a stretch of pattern changes the capitalization flag when it
+    /// is skipped. The single-pass generator keeps honouring `!`, and clearing
+    /// the flag on every character, even inside discarded alternatives.
+    enum effect_t {
+        EFFECT_KEEP, ///< Leaves the flag untouched.
+        EFFECT_SET,  ///< Ends with a `!`, and sets the flag.
+        EFFECT_CLEAR ///< Ends with a character, and clears the flag.
+    };
+
+    /// @brief A single element of an alternative.
+    struct item {
+        /// The kind of item.
+        item_kind_t kind;
+        /// The key of a token, or the character of a literal.
+        unsigned char value;
+        /// The table of a token item.
+        const token_table *table;
+        /// The index of a nested group.
+        std::size_t group;
+    };
+
+    /// @brief One of the options of a group.
+    struct alternative {
+        /// Index of the first item.
+        std::size_t first;
+        /// Index past the last item.
+        std::size_t last;
+        /// Effect on the capitalization flag when the alternative is skipped.
+        effect_t effect;
+        /// Combined effect of all the alternatives that follow this one.
+        effect_t tail;
+        /// Probability of this alternative being the one finally selected.
+        double probability;
+        /// The weight of the alternative, 1 if it has none.
+        uint32_t weight;
+    };
+
+    /// @brief A group of alternatives.
+    struct group {
+        /// Index of the first alternative.
+        std::size_t first;
+        /// Index past the last alternative.
+        std::size_t last;
+        /// If the group is a literal `(...)` one.
+        bool literal;
+        /// Effect on the capitalization flag when the whole group is skipped.
+        effect_t effect;
+        /// If the alternatives are selected through an alias table, because
+        /// some of them have a weight.
+        bool weighted;
+        /// Index of the first entry of the alias table of a weighted group.
+        std::size_t alias;
+    };
+
+    /// @brief How generate() produces the names of a compiled pattern.
+    enum engine_t {
+        ENGINE_TREE,    ///< Walks the tree, drawing like the single-pass generator.
+        ENGINE_TABLE,   ///< Draws a whole name from the materialized outputs.
+        ENGINE_BYTECODE ///< Runs the bytecode, drawing like the tree.
+    };
+
+    /// @brief The instructions of the bytecode. Each one is a word holding the
+    /// opcode in its low byte, and its first operand in the others, followed
+    /// by the words of its other operands, if any.
+    enum opcode_t {
+        OP_HALT,             ///< Ends the name.
+        OP_TOKEN,            ///< Emits a token from a table (operand).
+        OP_CAPITALIZE_TOKEN, ///< Emits a token from a table (operand), capitalized.
+        OP_TOKEN_PAIR,       ///< Emits a token from a table (operand), then one from a table (word).
+        OP_LITERAL_RUN,      ///< Emits a run of literals (length), starting at an offset (word).
+        OP_CAPITALIZE_NEXT,  ///< Capitalizes the next component.
+        OP_BEGIN,            ///< Saves the location and the flag at the start of a group.
+        OP_SWITCH,           ///< Draws, and either switches to the next alternative, or applies
+                             ///< its effect (operand) when the draw is not below a threshold
+                             ///< (word), and jumps past it (word).
+        OP_END,              ///< Drops the location and the flag saved by OP_BEGIN.
+        OP_CHOOSE,           ///< Draws one of several alternatives (operand) from an alias
+                             ///< table (word), and jumps to it through a table (words).
+        OP_EFFECT,           ///< Applies an effect (operand) to the flag.
+        OP_JUMP              ///< Jumps to a target (word).
+    };
+
+    /// @brief The pattern compiled into bytecode.
+    struct program {
+        /// The instructions.
+        std::vector<uint32_t> code;
+        /// The token tables used by the instructions.
+        std::vector<const token_table *> tables;
+        /// The runs of literals, back to back.
+        std::string literals;
+        /// The maximum length of a name.
+        std::size_t max_length;
+    };
+
+    /// @brief All the outputs of a pattern, with their probabilities.
+    struct output_table {
+        /// The outputs, back to back.
+        std::string pool;
+        /// Where each output starts.
+        std::vector<uint32_t> offsets;
+        /// The length of each output.
+        std::vector<uint32_t> lengths;
+        /// The probability of each output.
+        std::vector<double> probabilities;
+        /// The alias table of the outputs.
+        std::vector<alias_entry> aliases;
+    };
+
+    /// @brief The estimated cost of a name with each engine, in tenths of a
+    /// nanosecond on a typical core.
+    struct cost_estimate {
+        /// With the tree.
+        double tree;
+        /// With the table, infinite until the outputs are materialized.
+        double table;
+        /// With the bytecode.
+        double bytecode;
+    };
+
+    /// The items of all the alternatives.
+    std::vector<item> items;
+    /// The alternatives of all the groups.
+    std::vector<alternative> alternatives;
+    /// The groups, the first one is the root.
+    std::vector<group> groups;
+    /// The alias tables of the weighted groups.
+    std::vector<alias_entry> aliases;
+    /// The engine used by generate(), chosen by compile() between the tree
+    /// and the bytecode, or by calibrate() and set_engine() from engine.hpp.
+    engine_t engine;
+    /// The estimated costs that chose the engine, or the measured ones after
+    /// calibrate().
+    cost_estimate cost;
+    /// The outputs, materialized on demand by set_engine() and calibrate()
+    /// when the pattern has at most NAME_MATERIALIZE_LIMIT derivations.
+    output_table outputs;
+    /// The bytecode.
+    program bytecode;
+
+    /// @brief Creates an empty pattern.
+    pattern()
+        : items(),
+          alternatives(),
+          groups(),
+          aliases(),
+          engine(ENGINE_TREE),
+          cost(),
+          outputs(),
+          bytecode()
+    {
+    }
+};
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Combines two effects on the capitalization flag, applied in order.
+/// @param first the effect applied first.
+/// @param second the effect applied second.
+/// @return the combined effect.
+inline pattern::effect_t combine_effects(pattern::effect_t first, pattern::effect_t second)
+{
+    return (second == pattern::EFFECT_KEEP) ? first : second;
+}
+
+/// @brief Applies an effect to the capitalization flag.
+/// @param effect the effect.
+/// @param capitalize the current value of the flag.
+/// @return the new value of the flag.
+inline bool apply_effect(pattern::effect_t effect, bool capitalize)
+{
+    if (effect == pattern::EFFECT_SET) {
+        return true;
+    }
+    if (effect == pattern::EFFECT_CLEAR) {
+        return false;
+    }
+    return capitalize;
+}
+
+/// @brief Returns the probability of a token item selecting the given token.
+/// @param item the token item.
+/// @param index the index of the token.
+/// @return the probability, assuming uniform random numbers.
+inline double token_probability(const pattern::item &item, std::size_t index)
+{
+    return item.table->probability(index);
+}
+
+/// @brief Checks the structure of the pattern, in the same order as the
+/// single-pass generator, so that both report the same error.
+/// @param source the pattern.
+/// @return the outcome of the check.
+inline return_code_t validate(const std::string &source)
+{
+    int depth        = 0;
+    uint64_t literal = 0;
+    for (std::string::const_iterator it = source.begin(); it != source.end(); ++it) {
+        if ((*it == '<') || (*it == '(')) {
+            if (++depth == NAME_MAX_DEPTH) {
+                return TOO_DEEP;
+            }
+            if (*it == '(') {
+                literal |= 1UL << depth;
+            } else {
+                literal &= ~(1UL << depth);
+            }
+        } else if ((*it == '>') || (*it == ')')) {
+            if (depth == 0) {
+                return INVALID;
+            }
+            if (!(literal & (1UL << depth--)) != (*it == '>')) {
+                return INVALID;
+            }
+        }
+    }
+    return depth ? INVALID : SUCCESS;
+}
+
+/// @brief Appends a completed alternative to the compiled pattern.
+/// @param compiled the pattern being compiled.
+/// @param alternatives the alternatives of the current group.
+/// @param items the items of the alternative.
+/// @param weight the weight of the alternative.
+inline void close_alternative(
+    pattern &compiled,
+    std::vector<pattern::alternative> &alternatives,
+    std::vector<pattern::item> &items,
+    uint32_t weight)
+{
+    pattern::alternative alternative;
+    alternative.first  = compiled.items.size();
+    alternative.last   = alternative.first + items.size();
+    alternative.effect = pattern::EFFECT_KEEP;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (items[i].kind == pattern::ITEM_CAPITALIZE) {
+            alternative.effect = pattern::EFFECT_SET;
+        } else if (items[i].kind == pattern::ITEM_GROUP) {
+            alternative.effect = combine_effects(alternative.effect, compiled.groups[items[i].group].effect);
+        } else {
+            alternative.effect = pattern::EFFECT_CLEAR;
+        }
+    }
+    alternative.tail        = pattern::EFFECT_KEEP;
+    alternative.probability = 1;
+    alternative.weight      = weight;
+    compiled.items.insert(compiled.items.end(), items.begin(), items.end());
+    alternatives.push_back(alternative);
+    items.clear();
+}
+
+/// @brief Compiles a group, starting right after its opening bracket.
+/// @param compiled the pattern being compiled.
+/// @param source the pattern.
+/// @param position the current position inside the pattern, it is modified.
+/// @param literal if the group is a literal one.
+/// @param tables the dictionary of the token tables.
+/// @return the index of the group.
+inline std::size_t compile_group(
+    pattern &compiled,
+    const std::string &source,
+    std::size_t &position,
+    bool literal,
+    const dictionary &tables)
+{
+    std::size_t index = compiled.groups.size();
+    compiled.groups.push_back(pattern::group());
+
+    std::vector<pattern::alternative> alternatives;
+    std::vector<pattern::item> items;
+    uint32_t weight = 1;
+    bool weighted   = false;
+    while (position < source.size()) {
+        unsigned char c = static_cast<unsigned char>(source[position++]);
+        if ((c == '>') || (c == ')')) {
+            break;
+        }
+        if (c == '|') {
+            close_alternative(compiled, alternatives, items, weight);
+            weight = 1;
+            continue;
+        }
+        if (!literal && (c == ':') && get_weight_length(source, position - 1)) {
+            std::size_t length = get_weight_length(source, position - 1);
+            weight             = static_cast<uint32_t>(get_weight(source, position - 1, position - 1 + length));
+            weighted           = true;
+            position += length - 1;
+            continue;
+        }
+        pattern::item item;
+        item.value  = c;
+        item.table  = NULL;
+        item.group  = 0;
+        if ((c == '<') || (c == '(')) {
+            item.kind  = pattern::ITEM_GROUP;
+            item.group = compile_group(compiled, source, position, c == '(', tables);
+        } else if (c == '!') {
+            item.kind = pattern::ITEM_CAPITALIZE;
+        } else if (!literal && (c == '$') && (position < source.size()) && dictionary::is_name(static_cast<unsigned char>(source[position]))) {
+            // A name without a table leaves the dollar sign literal, as the
+            // single-pass generator emits it.
+            std::size_t end = position;
+            while ((end < source.size()) && dictionary::is_name(static_cast<unsigned char>(source[end]))) {
+                ++end;
+            }
+            item.table = tables.find(source.substr(position, end - position));
+            if (item.table && !item.table->empty()) {
+                item.kind = pattern::ITEM_TOKEN;
+                position  = end;
+            } else {
+                item.table = NULL;
+                item.kind  = pattern::ITEM_LITERAL;
+            }
+        } else if (!literal && (item.table = tables.find(c)) && !item.table->empty()) {
+            item.kind = pattern::ITEM_TOKEN;
+        } else {
+            item.kind = pattern::ITEM_LITERAL;
+        }
+        items.push_back(item);
+    }
+    close_alternative(compiled, alternatives, items, weight);
+    weighted = weighted && (alternatives.size() > 1);
+
+    // Compute the effects and the selection probabilities. Every alternative
+    // after the first replaces the current selection with probability
+    // `(0xffffffff / n) / 2^32`, and it is kept only if none of the following
+    // ones replaces it in turn. Weighted groups select each alternative with
+    // probability proportional to its weight instead.
+    pattern::effect_t effect = pattern::EFFECT_KEEP;
+    double kept              = 1;
+    double total             = 0;
+    for (std::size_t i = 0; i < alternatives.size(); ++i) {
+        total += alternatives[i].weight;
+    }
+    for (std::size_t i = alternatives.size(); i-- > 0;) {
+        double replace = i ? static_cast<double>(0xffffffffUL / (i + 1)) / 4294967296.0 : 1;
+
+        alternatives[i].tail = effect;
+        if (!weighted) {
+            alternatives[i].probability = replace * kept;
+        } else if (total > 0.) {
+            alternatives[i].probability = alternatives[i].weight / total;
+        } else {
+            alternatives[i].probability = i ? 0. : 1.;
+        }
+        effect = combine_effects(alternatives[i].effect, effect);
+        kept *= 1 - replace;
+    }
+
+    pattern::group &group = compiled.groups[index];
+    group.first           = compiled.alternatives.size();
+    group.last            = group.first + alternatives.size();
+    group.literal         = literal;
+    group.effect          = effect;
+    group.weighted        = weighted;
+    group.alias           = compiled.aliases.size();
+    if (weighted) {
+        std::vector<double> weights(alternatives.size());
+        std::vector<alias_entry> table;
+        for (std::size_t i = 0; i < alternatives.size(); ++i) {
+            weights[i] = alternatives[i].weight;
+        }
+        build_alias(table, weights);
+        compiled.aliases.insert(compiled.aliases.end(), table.begin(), table.end());
+    }
+    compiled.alternatives.insert(compiled.alternatives.end(), alternatives.begin(), alternatives.end());
+    return index;
+}
+
+/// @brief Records nothing, used when the choices taken during generation are
+/// of no interest.
+struct null_recorder {
+    /// @brief Returns the current position of the record.
+    std::size_t mark() const
+    {
+        return 0;
+    }
+
+    /// @brief Discards everything recorded after the given position.
+    void rewind(std::size_t)
+    {
+    }
+
+    /// @brief Records the index of a choice.
+    void choice(std::size_t)
+    {
+    }
+};
+
+/// @brief Writes a character inside the buffer, at the given location.
+/// @param buffer the buffer we manipulate.
+/// @param location the location where the character should be placed.
+/// @param c the character.
+/// @param capitalize controls capitalization of the character.
+inline void emit_literal(std::string &buffer, std::size_t &location, int c, bool capitalize)
+{
+    if (location == buffer.size()) {
+        buffer.resize(buffer.size() + 1);
+    }
+    buffer[location++] = get_capitalized(c, capitalize);
+}
+
+/// @brief Writes the selected token inside the buffer, at the given location.
+/// @param buffer the buffer we manipulate.
+/// @param location the location where the token should be placed.
+/// @param token the token.
+/// @param size the length of the token.
+/// @param capitalize controls capitalization of the first letter.
+inline void emit_token(std::string &buffer, std::size_t &location, const char *token, std::size_t size, bool capitalize)
+{
+    char *copy = insert_run(buffer, location, token, size);
+    if (capitalize) {
+        capitalize_token(copy, size);
+    }
+}
+
+template <typename Recorder>
+void run_group(const pattern &, std::size_t, std::string &, std::size_t &, bool &, uint64_t &, Recorder &);
+
+/// @brief Generates the given alternative.
+/// @param compiled the compiled pattern.
+/// @param index the index of the alternative.
+/// @param buffer the buffer we manipulate.
+/// @param location the current output location.
+/// @param capitalize the capitalization flag.
+/// @param seed the seed used for random number generation.
+/// @param recorder receives the choices taken.
+template <typename Recorder>
+void run_alternative(
+    const pattern &compiled,
+    std::size_t index,
+    std::string &buffer,
+    std::size_t &location,
+    bool &capitalize,
+    uint64_t &seed,
+    Recorder &recorder)
+{
+    const pattern::alternative &alternative = compiled.alternatives[index];
+    for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+        const pattern::item &item = compiled.items[i];
+        if (item.kind == pattern::ITEM_TOKEN) {
+            std::size_t select = item.table->select(seed);
+            if (item.table->size() > 1) {
+                recorder.choice(select);
+            }
+            emit_token(buffer, location, item.table->token(select), item.table->length(select), capitalize);
+            capitalize = false;
+        } else if (item.kind == pattern::ITEM_LITERAL) {
+            emit_literal(buffer, location, item.value, capitalize);
+            capitalize = false;
+        } else if (item.kind == pattern::ITEM_CAPITALIZE) {
+            capitalize = true;
+        } else {
+            run_group(compiled, item.group, buffer, location, capitalize, seed, recorder);
+        }
+    }
+}
+
+/// @brief Generates the given group, selecting its alternatives with the same
+/// reservoir sampling used by the single-pass generator, or with a single draw
+/// from the alias table of a weighted group.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @param buffer the buffer we manipulate.
+/// @param location the current output location.
+/// @param capitalize the capitalization flag.
+/// @param seed the seed used for random number generation.
+/// @param recorder receives the choices taken.
+template <typename Recorder>
+void run_group(
+    const pattern &compiled,
+    std::size_t index,
+    std::string &buffer,
+    std::size_t &location,
+    bool &capitalize,
+    uint64_t &seed,
+    Recorder &recorder)
+{
+    const pattern::group &group = compiled.groups[index];
+    if (group.weighted) {
+        std::size_t select = sample_alias(&compiled.aliases[group.alias], group.last - group.first, get_rand(seed));
+        recorder.choice(select);
+        run_alternative(compiled, group.first + select, buffer, location, capitalize, seed, recorder);
+        capitalize = apply_effect(compiled.alternatives[group.first + select].tail, capitalize);
+        return;
+    }
+    // Reset pointer (undo generate).
+    std::size_t reset = location;
+    // Initial capitalization state.
+    bool entry = capitalize;
+    // Position of the choice inside the record.
+    std::size_t mark = recorder.mark();
+    if ((group.last - group.first) > 1) {
+        recorder.choice(0);
+    }
+    run_alternative(compiled, group.first, buffer, location, capitalize, seed, recorder);
+    for (std::size_t i = group.first + 1; i < group.last; ++i) {
+        if (get_rand(seed) < (0xffffffffUL / (i - group.first + 1))) {
+            // Switch to this option.
+            location   = reset;
+            capitalize = entry;
+            recorder.rewind(mark);
+            recorder.choice(i - group.first);
+            run_alternative(compiled, i, buffer, location, capitalize, seed, recorder);
+        } else {
+            // Skip this option.
+            capitalize = apply_effect(compiled.alternatives[i].effect, capitalize);
+        }
+    }
+}
+
+/// @brief Returns the maximum length of the names of a group.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @return the length of the longest name.
+inline std::size_t get_max_length(const pattern &compiled, std::size_t index)
+{
+    const pattern::group &group = compiled.groups[index];
+    std::size_t result          = 0;
+    for (std::size_t i = group.first; i < group.last; ++i) {
+        const pattern::alternative &alternative = compiled.alternatives[i];
+        std::size_t length                      = 0;
+        for (std::size_t j = alternative.first; j < alternative.last; ++j) {
+            const pattern::item &item = compiled.items[j];
+            if (item.kind == pattern::ITEM_TOKEN) {
+                std::size_t longest = 0;
+                for (std::size_t k = 0; k < item.table->size(); ++k) {
+                    longest = std::max(longest, item.table->length(k));
+                }
+                length += longest;
+            } else if (item.kind == pattern::ITEM_LITERAL) {
+                ++length;
+            } else if (item.kind == pattern::ITEM_GROUP) {
+                length += get_max_length(compiled, item.group);
+            }
+        }
+        result = std::max(result, length);
+    }
+    return result;
+}
+
+/// @brief Appends an instruction to the bytecode.
+/// @param program the bytecode.
+/// @param opcode the opcode.
+/// @param operand the first operand.
+inline void emit_instruction(pattern::program &program, pattern::opcode_t opcode, std::size_t operand)
+{
+    program.code.push_back(static_cast<uint32_t>(opcode) | static_cast<uint32_t>(operand << 8));
+}
+
+/// @brief Returns the index of a token table inside the bytecode, adding it
+/// if needed.
+/// @param program the bytecode.
+/// @param table the token table.
+/// @return the index of the table.
+inline std::size_t get_program_table(pattern::program &program, const token_table *table)
+{
+    std::size_t index = std::find(program.tables.begin(), program.tables.end(), table) - program.tables.begin();
+    if (index == program.tables.size()) {
+        program.tables.push_back(table);
+    }
+    return index;
+}
+
+inline void compile_program_group(pattern::program &, const pattern &, std::size_t);
+
+/// @brief Compiles an alternative into bytecode, fusing a `!` with the token
+/// that follows it, two tokens in a row, and consecutive literals.
+/// @param program the bytecode.
+/// @param compiled the compiled pattern.
+/// @param index the index of the alternative.
+inline void compile_program_alternative(pattern::program &program, const pattern &compiled, std::size_t index)
+{
+    const pattern::alternative &alternative = compiled.alternatives[index];
+    for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+        const pattern::item &item = compiled.items[i];
+        const pattern::item *next = (i + 1 < alternative.last) ? &compiled.items[i + 1] : NULL;
+        if (item.kind == pattern::ITEM_TOKEN) {
+            emit_instruction(
+                program, (next && next->kind == pattern::ITEM_TOKEN) ? pattern::OP_TOKEN_PAIR : pattern::OP_TOKEN,
+                get_program_table(program, item.table));
+            if (next && next->kind == pattern::ITEM_TOKEN) {
+                program.code.push_back(static_cast<uint32_t>(get_program_table(program, next->table)));
+                ++i;
+            }
+        } else if (item.kind == pattern::ITEM_LITERAL) {
+            std::size_t offset = program.literals.size();
+            for (; (i < alternative.last) && (compiled.items[i].kind == pattern::ITEM_LITERAL); ++i) {
+                program.literals += static_cast<char>(compiled.items[i].value);
+            }
+            --i;
+            emit_instruction(program, pattern::OP_LITERAL_RUN, program.literals.size() - offset);
+            program.code.push_back(static_cast<uint32_t>(offset));
+        } else if (item.kind == pattern::ITEM_CAPITALIZE) {
+            if (next && next->kind == pattern::ITEM_TOKEN) {
+                emit_instruction(program, pattern::OP_CAPITALIZE_TOKEN, get_program_table(program, next->table));
+                ++i;
+            } else {
+                emit_instruction(program, pattern::OP_CAPITALIZE_NEXT, 0);
+            }
+        } else {
+            compile_program_group(program, compiled, item.group);
+        }
+    }
+}
+
+/// @brief Compiles a group into bytecode. Weighted groups jump to the
+/// alternative drawn from their alias table, the others run the first
+/// alternative, and then switch to each of the following ones, or skip it,
+/// like run_group().
+/// @param program the bytecode.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+inline void compile_program_group(pattern::program &program, const pattern &compiled, std::size_t index)
+{
+    const pattern::group &group = compiled.groups[index];
+    std::size_t count           = group.last - group.first;
+    if (group.weighted) {
+        emit_instruction(program, pattern::OP_CHOOSE, count);
+        program.code.push_back(static_cast<uint32_t>(group.alias));
+        std::size_t targets = program.code.size();
+        program.code.resize(targets + count);
+        std::vector<std::size_t> jumps;
+        for (std::size_t i = 0; i < count; ++i) {
+            const pattern::alternative &alternative = compiled.alternatives[group.first + i];
+            program.code[targets + i]               = static_cast<uint32_t>(program.code.size());
+            compile_program_alternative(program, compiled, group.first + i);
+            if (alternative.tail != pattern::EFFECT_KEEP) {
+                emit_instruction(program, pattern::OP_EFFECT, alternative.tail);
+            }
+            if (i + 1 < count) {
+                emit_instruction(program, pattern::OP_JUMP, 0);
+                jumps.push_back(program.code.size());
+                program.code.push_back(0);
+            }
+        }
+        for (std::size_t i = 0; i < jumps.size(); ++i) {
+            program.code[jumps[i]] = static_cast<uint32_t>(program.code.size());
+        }
+        return;
+    }
+    if (count == 1) {
+        compile_program_alternative(program, compiled, group.first);
+        return;
+    }
+    emit_instruction(program, pattern::OP_BEGIN, 0);
+    compile_program_alternative(program, compiled, group.first);
+    for (std::size_t i = 1; i < count; ++i) {
+        emit_instruction(program, pattern::OP_SWITCH, compiled.alternatives[group.first + i].effect);
+        program.code.push_back(static_cast<uint32_t>(0xffffffffUL / (i + 1)));
+        std::size_t target = program.code.size();
+        program.code.push_back(0);
+        compile_program_alternative(program, compiled, group.first + i);
+        program.code[target] = static_cast<uint32_t>(program.code.size());
+    }
+    emit_instruction(program, pattern::OP_END, 0);
+}
+
+/// @brief Compiles the pattern into bytecode.
+/// @param compiled the compiled pattern.
+inline void compile_program(pattern &compiled)
+{
+    pattern::program &program = compiled.bytecode;
+    compile_program_group(program, compiled, 0);
+    emit_instruction(program, pattern::OP_HALT, 0);
+    program.max_length = get_max_length(compiled, 0);
+}
+
+/// @brief Copies a token selected from a table.
+/// @param out where the token is copied.
+/// @param table the token table.
+/// @param seed the seed used for random number generation.
+/// @param capitalize controls capitalization of the first letter.
+/// @return the length of the token.
+inline std::size_t copy_token(char *out, const token_table &table, uint64_t &seed, bool capitalize)
+{
+    std::size_t select = table.select(seed);
+    std::size_t length = table.length(select);
+    std::memcpy(out, table.token(select), length);
+    if (capitalize) {
+        capitalize_token(out, length);
+    }
+    return length;
+}
+
+#if NAME_THREADED_DISPATCH
+// Labels as values are a GNU extension.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+/// @brief Runs the bytecode of a pattern, which draws the same numbers as
+/// run_group().
+/// @param compiled the compiled pattern.
+/// @param buffer the buffer we manipulate, grown to hold the longest name.
+/// @param location the location where the name starts.
+/// @param seed the seed used for random number generation.
+/// @return the location past the end of the name.
+inline std::size_t run_program(const pattern &compiled, std::string &buffer, std::size_t location, uint64_t &seed)
+{
+    const pattern::program &program = compiled.bytecode;
+    if (buffer.size() < location + program.max_length) {
+        buffer.resize(location + program.max_length);
+    }
+    char *out                        = &buffer[0];
+    const uint32_t *code             = program.code.data();
+    const uint32_t *pc               = code;
+    const token_table *const *tables = program.tables.data();
+    bool capitalize                  = false;
+    // The location and the flag at the start of the enclosing groups.
+    std::size_t resets[NAME_MAX_DEPTH + 1];
+    bool entries[NAME_MAX_DEPTH + 1];
+    std::size_t depth = 0;
+#if NAME_THREADED_DISPATCH
+    static const void *const labels[] = {
+        &&op_halt, &&op_token, &&op_capitalize_token, &&op_token_pair, &&op_literal_run, &&op_capitalize_next,
+        &&op_begin, &&op_switch, &&op_end, &&op_choose, &&op_effect, &&op_jump
+    };
+#define NAME_DISPATCH() goto *labels[*pc & 0xffU]
+#else
+#define NAME_DISPATCH() goto dispatch
+dispatch:
+    switch (*pc & 0xffU) {
+    case pattern::OP_TOKEN: goto op_token;
+    case pattern::OP_CAPITALIZE_TOKEN: goto op_capitalize_token;
+    case pattern::OP_TOKEN_PAIR: goto op_token_pair;
+    case pattern::OP_LITERAL_RUN: goto op_literal_run;
+    case pattern::OP_CAPITALIZE_NEXT: goto op_capitalize_next;
+    case pattern::OP_BEGIN: goto op_begin;
+    case pattern::OP_SWITCH: goto op_switch;
+    case pattern::OP_END: goto op_end;
+    case pattern::OP_CHOOSE: goto op_choose;
+    case pattern::OP_EFFECT: goto op_effect;
+    case pattern::OP_JUMP: goto op_jump;
+    default: goto op_halt;
+    }
+#endif
+    NAME_DISPATCH();
+op_token:
+    location += copy_token(out + location, *tables[*pc >> 8], seed, capitalize);
+    capitalize = false;
+    pc += 1;
+    NAME_DISPATCH();
+op_capitalize_token:
+    location += copy_token(out + location, *tables[*pc >> 8], seed, true);
+    capitalize = false;
+    pc += 1;
+    NAME_DISPATCH();
+op_token_pair:
+    location += copy_token(out + location, *tables[*pc >> 8], seed, capitalize);
+    location += copy_token(out + location, *tables[pc[1]], seed, false);
+    capitalize = false;
+    pc += 2;
+    NAME_DISPATCH();
+op_literal_run:
+    std::memcpy(out + location, program.literals.data() + pc[1], *pc >> 8);
+    out[location] = get_capitalized(out[location], capitalize);
+    location += *pc >> 8;
+    capitalize = false;
+    pc += 2;
+    NAME_DISPATCH();
+op_capitalize_next:
+    capitalize = true;
+    pc += 1;
+    NAME_DISPATCH();
+op_begin:
+    resets[depth]  = location;
+    entries[depth] = capitalize;
+    ++depth;
+    pc += 1;
+    NAME_DISPATCH();
+op_switch:
+    if (get_rand(seed) < pc[1]) {
+        location   = resets[depth - 1];
+        capitalize = entries[depth - 1];
+        pc += 3;
+    } else {
+        capitalize = apply_effect(static_cast<pattern::effect_t>(*pc >> 8), capitalize);
+        pc         = code + pc[2];
+    }
+    NAME_DISPATCH();
+op_end:
+    --depth;
+    pc += 1;
+    NAME_DISPATCH();
+op_choose:
+    pc = code + pc[2 + sample_alias(&compiled.aliases[pc[1]], *pc >> 8, get_rand(seed))];
+    NAME_DISPATCH();
+op_effect:
+    capitalize = apply_effect(static_cast<pattern::effect_t>(*pc >> 8), capitalize);
+    pc += 1;
+    NAME_DISPATCH();
+op_jump:
+    pc = code + pc[1];
+    NAME_DISPATCH();
+#undef NAME_DISPATCH
+op_halt:
+    return location;
+}
+
+#if NAME_THREADED_DISPATCH
+#pragma GCC diagnostic pop
+#endif
+
+/// @brief Counts the derivations of a group, stopping once past the limit.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @return the number of derivations, NAME_MATERIALIZE_LIMIT + 1 if there are
+/// more.
+inline std::size_t count_derivations(const pattern &compiled, std::size_t index)
+{
+    const pattern::group &group = compiled.groups[index];
+    std::size_t result          = 0;
+    for (std::size_t i = group.first; i < group.last; ++i) {
+        const pattern::alternative &alternative = compiled.alternatives[i];
+        std::size_t count                       = 1;
+        for (std::size_t j = alternative.first; (j < alternative.last) && (count <= NAME_MATERIALIZE_LIMIT); ++j) {
+            const pattern::item &item = compiled.items[j];
+            if (item.kind == pattern::ITEM_TOKEN) {
+                count *= std::min(item.table->size(), static_cast<std::size_t>(NAME_MATERIALIZE_LIMIT + 1));
+            } else if (item.kind == pattern::ITEM_GROUP) {
+                count *= count_derivations(compiled, item.group);
+            }
+        }
+        result += std::min(count, static_cast<std::size_t>(NAME_MATERIALIZE_LIMIT + 1));
+        if (result > NAME_MATERIALIZE_LIMIT) {
+            return NAME_MATERIALIZE_LIMIT + 1;
+        }
+    }
+    return result;
+}
+
+/// @brief An output being built by the enumeration of a pattern.
+struct partial_output {
+    /// The characters so far.
+    std::string text;
+    /// The capitalization flag.
+    bool capitalize;
+    /// The probability of the derivation so far.
+    double probability;
+};
+
+inline void enumerate_group(const pattern &, std::size_t, std::vector<partial_output> &);
+
+/// @brief Extends the partial outputs with all the derivations of an
+/// alternative.
+/// @param compiled the compiled pattern.
+/// @param index the index of the alternative.
+/// @param outputs the partial outputs, they are replaced by their extensions.
+inline void enumerate_alternative(const pattern &compiled, std::size_t index, std::vector<partial_output> &outputs)
+{
+    const pattern::alternative &alternative = compiled.alternatives[index];
+    std::vector<partial_output> extended;
+    for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+        const pattern::item &item = compiled.items[i];
+        if (item.kind == pattern::ITEM_TOKEN) {
+            extended.clear();
+            for (std::size_t j = 0; j < outputs.size(); ++j) {
+                for (std::size_t k = 0; k < item.table->size(); ++k) {
+                    double probability = outputs[j].probability * token_probability(item, k);
+                    if (probability > 0.) {
+                        partial_output output = outputs[j];
+                        std::size_t location  = output.text.size();
+                        emit_token(output.text, location, item.table->token(k), item.table->length(k), output.capitalize);
+                        output.capitalize  = false;
+                        output.probability = probability;
+                        extended.push_back(output);
+                    }
+                }
+            }
+            outputs.swap(extended);
+        } else if (item.kind == pattern::ITEM_GROUP) {
+            enumerate_group(compiled, item.group, outputs);
+        } else {
+            for (std::size_t j = 0; j < outputs.size(); ++j) {
+                if (item.kind == pattern::ITEM_LITERAL) {
+                    outputs[j].text += get_capitalized(item.value, outputs[j].capitalize);
+                }
+                outputs[j].capitalize = (item.kind == pattern::ITEM_CAPITALIZE);
+            }
+        }
+    }
+}
+
+/// @brief Extends the partial outputs with all the derivations of a group.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @param outputs the partial outputs, they are replaced by their extensions.
+inline void enumerate_group(const pattern &compiled, std::size_t index, std::vector<partial_output> &outputs)
+{
+    const pattern::group &group = compiled.groups[index];
+    std::vector<partial_output> result, current;
+    for (std::size_t i = group.first; i < group.last; ++i) {
+        const pattern::alternative &alternative = compiled.alternatives[i];
+        if (alternative.probability <= 0.) {
+            continue;
+        }
+        current = outputs;
+        for (std::size_t j = 0; j < current.size(); ++j) {
+            current[j].probability *= alternative.probability;
+        }
+        enumerate_alternative(compiled, i, current);
+        // The alternatives after the selected one are skipped.
+        for (std::size_t j = 0; j < current.size(); ++j) {
+            current[j].capitalize = apply_effect(alternative.tail, current[j].capitalize);
+        }
+        result.insert(result.end(), current.begin(), current.end());
+    }
+    outputs.swap(result);
+}
+
+/// @brief Stores every output of the pattern, with its probability, summing
+/// the derivations that give the same name.
+/// @param compiled the compiled pattern.
+inline void materialize(pattern &compiled)
+{
+    std::vector<partial_output> outputs(1);
+    outputs[0].capitalize  = false;
+    outputs[0].probability = 1.;
+    enumerate_group(compiled, 0, outputs);
+    std::map<std::string, double> merged;
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+        merged[outputs[i].text] += outputs[i].probability;
+    }
+    pattern::output_table &table = compiled.outputs;
+    for (std::map<std::string, double>::const_iterator it = merged.begin(); it != merged.end(); ++it) {
+        table.offsets.push_back(static_cast<uint32_t>(table.pool.size()));
+        table.lengths.push_back(static_cast<uint32_t>(it->first.size()));
+        table.probabilities.push_back(it->second);
+        table.pool += it->first;
+    }
+    build_alias(table.aliases, table.probabilities);
+}
+
+/// The costs of the operations of the engines, in tenths of a nanosecond.
+static const double COST_DRAW            = 100.; ///< Drawing a random number.
+static const double COST_ITEM            = 40.;  ///< Visiting an item of the tree.
+static const double COST_CHARACTER       = 30.;  ///< Writing a character, one at a time.
+static const double COST_INSTRUCTION     = 25.;  ///< Dispatching an instruction of the bytecode.
+static const double COST_COPY_CHARACTER  = 10.;  ///< Copying a character of a token or of a run.
+static const double COST_TABLE           = 240.; ///< Drawing an output of the table.
+static const double COST_TABLE_CHARACTER = 5.;   ///< Copying a character of an output.
+
+/// @brief Estimates the cost of generating a group by walking it, with the
+/// tree or with the bytecode.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @param item_cost the cost of visiting an item.
+/// @param character_cost the cost of writing a character.
+/// @return the expected cost.
+inline double estimate_walk_cost(const pattern &compiled, std::size_t index, double item_cost, double character_cost)
+{
+    const pattern::group &group = compiled.groups[index];
+    double result               = group.weighted ? COST_DRAW : 0;
+    for (std::size_t i = group.first; i < group.last; ++i) {
+        const pattern::alternative &alternative = compiled.alternatives[i];
+        double cost                             = 0;
+        for (std::size_t j = alternative.first; j < alternative.last; ++j) {
+            const pattern::item &item = compiled.items[j];
+            cost += item_cost;
+            if (item.kind == pattern::ITEM_TOKEN) {
+                double length = 0;
+                for (std::size_t k = 0; k < item.table->size(); ++k) {
+                    length += token_probability(item, k) * static_cast<double>(item.table->length(k));
+                }
+                cost += COST_DRAW + length * character_cost;
+            } else if (item.kind == pattern::ITEM_LITERAL) {
+                cost += character_cost;
+            } else if (item.kind == pattern::ITEM_GROUP) {
+                cost += estimate_walk_cost(compiled, item.group, item_cost, character_cost);
+            }
+        }
+        if (group.weighted) {
+            // Only the selected alternative is walked.
+            result += alternative.probability * cost;
+        } else if (i == group.first) {
+            result += cost;
+        } else {
+            // A draw, and a walk whenever the reservoir switches.
+            std::size_t n = i - group.first + 1;
+            result += COST_DRAW + (static_cast<double>(0xffffffffUL / n) / 4294967296.0) * cost;
+        }
+    }
+    return result;
+}
+
+/// @brief Chooses the cheapest engine that draws like the single-pass
+/// generator, from the estimated costs alone.
+/// @param compiled the compiled pattern.
+inline void choose_engine(pattern &compiled)
+{
+    compiled.cost.tree     = estimate_walk_cost(compiled, 0, COST_ITEM, COST_CHARACTER);
+    compiled.cost.bytecode = estimate_walk_cost(compiled, 0, COST_INSTRUCTION, COST_COPY_CHARACTER);
+    compiled.cost.table    = std::numeric_limits<double>::infinity();
+    compiled.engine        = (compiled.cost.bytecode < compiled.cost.tree) ? pattern::ENGINE_BYTECODE : pattern::ENGINE_TREE;
+}
+
+/// @brief Materializes the outputs of the pattern, unless it already is, and
+/// estimates the cost of the table.
+/// @param compiled the compiled pattern.
+/// @return false if the pattern has too many derivations to be materialized.
+inline bool build_outputs(pattern &compiled)
+{
+    if (!compiled.outputs.lengths.empty()) {
+        return true;
+    }
+    if (count_derivations(compiled, 0) > NAME_MATERIALIZE_LIMIT) {
+        return false;
+    }
+    materialize(compiled);
+    double length = 0;
+    for (std::size_t i = 0; i < compiled.outputs.lengths.size(); ++i) {
+        length += compiled.outputs.probabilities[i] * compiled.outputs.lengths[i];
+    }
+    compiled.cost.table = COST_TABLE + length * COST_TABLE_CHARACTER;
+    return true;
+}
+
+/// @brief Draws an output from the table of a materialized pattern.
+/// @param compiled the compiled pattern.
+/// @param seed the seed used for random number generation.
+/// @return the index of the output.
+inline std::size_t select_output(const pattern &compiled, uint64_t &seed)
+{
+    return sample_alias(&compiled.outputs.aliases[0], compiled.outputs.lengths.size(), get_rand(seed));
+}
+
+} // namespace detail
+
+/// @brief Compiles the pattern into a tree, taking the token tables from a
+/// dictionary.
+/// @param compiled the compiled pattern.
+/// @param source the pattern to compile.
+/// @param tables the dictionary, which must outlive the compiled pattern.
+/// @return SUCCESS, or the same error the single-pass generator reports for
+/// the pattern, in which case compiled is left empty. A name missing from
+/// the dictionary is not an error: its dollar sign is emitted literally.
+inline return_code_t compile(pattern &compiled, const std::string &source, const dictionary &tables)
+{
+    compiled = pattern();
+    return_code_t ret = detail::validate(source);
+    if (ret == SUCCESS) {
+        std::size_t position = 0;
+        detail::compile_group(compiled, source, position, false, tables);
+    }
+    if (ret != SUCCESS) {
+        compiled = pattern();
+    } else {
+        detail::compile_program(compiled);
+        detail::choose_engine(compiled);
+    }
+    return ret;
+}
+
+/// @brief Compiles the pattern into a tree, with the built-in token tables.
+/// @param compiled the compiled pattern.
+/// @param source the pattern to compile.
+/// @return SUCCESS, or the same error the single-pass generator reports for
+/// the pattern, in which case compiled is left empty.
+inline return_code_t compile(pattern &compiled, const std::string &source)
+{
+    static const dictionary builtin;
+    return compile(compiled, source, builtin);
+}
+
+/// @brief Generate a random name based on a compiled pattern and a given seed,
+/// and saves it into buffer.
+/// @param buffer the string where the name is placed.
+/// @param compiled the compiled pattern.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, or INVALID if the pattern was never compiled.
+inline return_code_t generate(std::string &buffer, const pattern &compiled, uint64_t &seed)
+{
+    if (compiled.groups.empty()) {
+        buffer.clear();
+        return INVALID;
+    }
+    if (compiled.engine == pattern::ENGINE_TABLE) {
+        std::size_t select = detail::select_output(compiled, seed);
+        buffer.assign(compiled.outputs.pool, compiled.outputs.offsets[select], compiled.outputs.lengths[select]);
+        return SUCCESS;
+    }
+    if (compiled.engine == pattern::ENGINE_BYTECODE) {
+        buffer.resize(detail::run_program(compiled, buffer, 0, seed));
+        return SUCCESS;
+    }
+    std::size_t location = 0;
+    bool capitalize      = false;
+    detail::null_recorder recorder;
+    detail::run_group(compiled, 0, buffer, location, capitalize, seed, recorder);
+    buffer.resize(location);
+    return SUCCESS;
+}
+
+} // namespace namegen
@@ -0,0 +1,208 @@
+/// @file probability.hpp
+/// @brief Likelihood of names, and enumeration of the most probable ones.
+/// @details
+/// A name can often be generated in more than one way, e.g. "a" by both
+/// alternatives of "<v|V>". Its probability is the sum over all the paths of
+/// the pattern automaton that spell it, which accounts for the reservoir
+/// selection of the alternatives and for the weighted selection of the tokens.
+/// Both are computed by dynamic programming, without sampling.
+
+#pragma once
+
+#include "namegen/automaton.hpp"
+
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace namegen
+{
+
+/// @brief A name paired with its probability.
+struct scored_name {
+    /// The name.
+    std::string name;
+    /// The natural logarithm of the probability of generating the name.
+    double log_probability;
+};
+
+/// @brief Computes the probability of generating the given name.
+/// @param names the automaton of the pattern.
+/// @param name the name.
+/// @return the natural logarithm of the probability, or minus infinity if the
+/// pattern cannot generate the name.
+inline double log_probability(const automaton &names, const std::string &name)
+{
+    // Probability of reaching each state after reading each prefix of the name.
+    std::size_t width = name.size() + 1;
+    std::vector<double> reach(names.size() * width, 0.);
+    reach[names.start() * width] = 1;
+    for (uint32_t s = 0; s < names.size(); ++s) {
+        for (std::size_t i = 0; i < width; ++i) {
+            double mass = reach[s * width + i];
+            if (mass == 0.) {
+                continue;
+            }
+            for (const automaton::edge *e = names.begin(s); e != names.end(s); ++e) {
+                if (e->symbol == automaton::epsilon) {
+                    reach[e->target * width + i] += mass * e->weight;
+                } else if ((i < name.size()) && (e->symbol == static_cast<unsigned char>(name[i]))) {
+                    reach[e->target * width + i + 1] += mass * e->weight;
+                }
+            }
+        }
+    }
+    double probability = reach[names.final_state() * width + name.size()];
+    return (probability > 0.) ? std::log(probability) : -std::numeric_limits<double>::infinity();
+}
+
+/// @brief Computes the probability of generating the given name.
+/// @param compiled the compiled pattern.
+/// @param name the name.
+/// @return the natural logarithm of the probability, or minus infinity if the
+/// pattern cannot generate the name.
+inline double log_probability(const pattern &compiled, const std::string &name)
+{
+    if (compiled.groups.empty()) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return log_probability(automaton(compiled), name);
+}
+
+/// @brief Computes the probabilities of generating many names.
+/// @param results the natural logarithm of the probability of each name.
+/// @param names the automaton of the pattern.
+/// @param candidates the names.
+inline void log_probability(std::vector<double> &results, const automaton &names, const std::vector<std::string> &candidates)
+{
+    results.resize(candidates.size());
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        results[i] = log_probability(names, candidates[i]);
+    }
+}
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief A prefix explored by the best-first enumeration.
+struct prefix_candidate {
+    /// The probability of any name starting with the prefix, or of the name
+    /// itself once complete.
+    double probability;
+    /// True if the candidate is a complete name.
+    bool complete;
+    /// The prefix.
+    std::string prefix;
+    /// The probability of each state after reading the prefix.
+    std::map<uint32_t, double> states;
+
+    bool operator<(const prefix_candidate &other) const
+    {
+        if (probability != other.probability) {
+            return probability < other.probability;
+        }
+        // On ties, complete names are returned first.
+        return !complete && other.complete;
+    }
+};
+
+/// @brief Moves the probability of each state along its epsilon edges.
+/// @param names the automaton.
+/// @param states the probability of each state.
+inline void propagate(const automaton &names, std::map<uint32_t, double> &states)
+{
+    // Edges lead to greater states, so a single ordered sweep is enough.
+    for (std::map<uint32_t, double>::iterator it = states.begin(); it != states.end(); ++it) {
+        for (const automaton::edge *e = names.begin(it->first); e != names.end(it->first); ++e) {
+            if (e->symbol == automaton::epsilon) {
+                states[e->target] += it->second * e->weight;
+            }
+        }
+    }
+}
+
+/// @brief Computes the probability of any name continuing from the states.
+/// @param names the automaton.
+/// @param states the probability of each state, after propagation.
+/// @return the probability.
+inline double prefix_probability(const automaton &names, const std::map<uint32_t, double> &states)
+{
+    double probability = 0;
+    for (std::map<uint32_t, double>::const_iterator it = states.begin(); it != states.end(); ++it) {
+        if (it->first == names.final_state()) {
+            probability += it->second;
+        }
+        for (const automaton::edge *e = names.begin(it->first); e != names.end(it->first); ++e) {
+            if (e->symbol != automaton::epsilon) {
+                probability += it->second * e->weight;
+            }
+        }
+    }
+    return probability;
+}
+
+} // namespace detail
+
+/// @brief Enumerates the most probable names of a pattern.
+/// @details Prefixes are explored best-first, ordered by the probability of
+/// generating any name that starts with them. That probability never grows
+/// when a prefix is extended, hence a complete name extracted from the queue
+/// is more probable than any name not yet returned.
+/// @param results the names, from the most probable one.
+/// @param names the automaton of the pattern.
+/// @param k the number of names wanted.
+inline void top_k(std::vector<scored_name> &results, const automaton &names, std::size_t k)
+{
+    results.clear();
+    std::priority_queue<detail::prefix_candidate> queue;
+    detail::prefix_candidate initial;
+    initial.complete                  = false;
+    initial.states[names.start()] = 1;
+    detail::propagate(names, initial.states);
+    initial.probability = detail::prefix_probability(names, initial.states);
+    queue.push(initial);
+    while (!queue.empty() && (results.size() < k)) {
+        detail::prefix_candidate current = queue.top();
+        queue.pop();
+        if (current.complete) {
+            scored_name result;
+            result.name            = current.prefix;
+            result.log_probability = std::log(current.probability);
+            results.push_back(result);
+            continue;
+        }
+        // The prefix itself, as a complete name.
+        std::map<uint32_t, double>::const_iterator end = current.states.find(names.final_state());
+        if ((end != current.states.end()) && (end->second > 0.)) {
+            detail::prefix_candidate complete;
+            complete.probability = end->second;
+            complete.complete    = true;
+            complete.prefix      = current.prefix;
+            queue.push(complete);
+        }
+        // The prefix extended by one byte.
+        std::map<int, std::map<uint32_t, double> > children;
+        for (std::map<uint32_t, double>::const_iterator it = current.states.begin(); it != current.states.end(); ++it) {
+            for (const automaton::edge *e = names.begin(it->first); e != names.end(it->first); ++e) {
+                if (e->symbol != automaton::epsilon) {
+                    children[e->symbol][e->target] += it->second * e->weight;
+                }
+            }
+        }
+        for (std::map<int, std::map<uint32_t, double> >::iterator it = children.begin(); it != children.end(); ++it) {
+            detail::prefix_candidate child;
+            child.complete = false;
+            child.prefix   = current.prefix;
+            child.prefix.push_back(static_cast<char>(it->first));
+            child.states.swap(it->second);
+            detail::propagate(names, child.states);
+            child.probability = detail::prefix_probability(names, child.states);
+            if (child.probability > 0.) {
+                queue.push(child);
+            }
+        }
+    }
+}
+
+} // namespace namegen
@@ -0,0 +1,245 @@
+/// @file queue.hpp
+/// @brief Bounded lock-free queue of names over a raw block of memory.
+/// @details
+/// The ring keeps all its state, indices included, inside the block it is
+/// given, and holds no pointers, so the block can live in shared memory and be
+/// used by several processes at once. Every cell stores a name of bounded
+/// length and a sequence number (Vyukov's bounded queue): producers and
+/// consumers claim cells by advancing the tail and the head with a
+/// compare-and-swap, and the sequence numbers tell them whether the cell is
+/// ready, so no lock is ever taken.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief A bounded queue of names, stored inside a block of memory.
+class name_ring {
+public:
+    /// @brief Creates a ring which is not bound to any memory.
+    name_ring()
+        : m_header(NULL),
+          m_cells(NULL)
+    {
+    }
+
+    /// @brief Returns the size of the block needed by a ring.
+    /// @param capacity the number of names, rounded up to a power of two.
+    /// @param max_length the maximum length of a name.
+    /// @return the size in bytes.
+    static std::size_t footprint(std::size_t capacity, std::size_t max_length)
+    {
+        return sizeof(header) + round_capacity(capacity) * cell_size(max_length);
+    }
+
+    /// @brief Initializes a ring inside a block of memory.
+    /// @param memory the block, aligned to 64 bytes, of at least footprint()
+    /// bytes, which must outlive the ring.
+    /// @param capacity the number of names, rounded up to a power of two.
+    /// @param max_length the maximum length of a name.
+    /// @return false if the atomic indices are not lock-free, in which case
+    /// they cannot be shared between processes.
+    bool create(void *memory, std::size_t capacity, std::size_t max_length)
+    {
+        capacity         = round_capacity(capacity);
+        header *state    = new (memory) header();
+        state->capacity  = capacity;
+        state->cell_size = cell_size(max_length);
+        state->head.store(0);
+        state->tail.store(0);
+        if (!state->head.is_lock_free()) {
+            return false;
+        }
+        char *cells = static_cast<char *>(memory) + sizeof(header);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            cell *current = new (cells + i * state->cell_size) cell();
+            current->sequence.store(i);
+            current->length = 0;
+        }
+        // The magic number goes last, and publishes the ring once it is ready.
+        state->magic.store(magic_number, std::memory_order_release);
+        m_header     = state;
+        m_cells      = cells;
+        return true;
+    }
+
+    /// @brief Binds to a ring created by create(), possibly by another process.
+    /// @param memory the block holding the ring.
+    /// @param size the size of the block.
+    /// @return false if the block does not hold a valid ring.
+    bool attach(void *memory, std::size_t size)
+    {
+        header *state = static_cast<header *>(memory);
+        if ((size < sizeof(header)) || (state->magic.load(std::memory_order_acquire) != magic_number)) {
+            return false;
+        }
+        if ((state->capacity == 0) || (state->capacity & (state->capacity - 1)) || (state->cell_size <= sizeof(cell)) ||
+            (state->capacity > (size - sizeof(header)) / state->cell_size)) {
+            return false;
+        }
+        m_header = state;
+        m_cells  = static_cast<char *>(memory) + sizeof(header);
+        return true;
+    }
+
+    /// @brief Returns true if the ring is bound to a block.
+    bool valid() const
+    {
+        return m_header != NULL;
+    }
+
+    /// @brief Returns the number of names the ring can hold.
+    std::size_t capacity() const
+    {
+        return static_cast<std::size_t>(m_header->capacity);
+    }
+
+    /// @brief Returns the maximum length of a name.
+    std::size_t max_length() const
+    {
+        return static_cast<std::size_t>(m_header->cell_size - sizeof(cell) - 1);
+    }
+
+    /// @brief Returns the number of names inside the ring, which can be out of
+    /// date as soon as it is returned.
+    std::size_t size() const
+    {
+        uint64_t head = m_header->head.load(std::memory_order_acquire);
+        uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+        return (tail > head) ? static_cast<std::size_t>(tail - head) : 0;
+    }
+
+    /// @brief Appends a name.
+    /// @param name the name.
+    /// @param length the length of the name, at most max_length().
+    /// @return false if the ring is full, or the name is too long.
+    bool push(const char *name, std::size_t length)
+    {
+        if (length > this->max_length()) {
+            return false;
+        }
+        uint64_t position = m_header->tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell *current    = this->at(position);
+            uint64_t ready   = current->sequence.load(std::memory_order_acquire);
+            int64_t distance = static_cast<int64_t>(ready - position);
+            if (distance == 0) {
+                if (m_header->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    current->length = length;
+                    std::memcpy(current->name(), name, length);
+                    current->name()[length] = 0;
+                    current->sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (distance < 0) {
+                return false;
+            } else {
+                position = m_header->tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// @brief Removes the oldest name.
+    /// @param buffer the string where the name is placed.
+    /// @return false if the ring is empty.
+    bool pop(std::string &buffer)
+    {
+        uint64_t position = m_header->head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell *current    = this->at(position);
+            uint64_t ready   = current->sequence.load(std::memory_order_acquire);
+            int64_t distance = static_cast<int64_t>(ready - (position + 1));
+            if (distance == 0) {
+                if (m_header->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    buffer.assign(current->name(), static_cast<std::size_t>(current->length));
+                    current->sequence.store(position + m_header->capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (distance < 0) {
+                return false;
+            } else {
+                position = m_header->head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    /// Marks an initialized ring.
+    enum { magic_number = 0x4e475231 };
+
+    /// @brief The state of the ring, at the start of the block.
+    struct header {
+        /// Set once the ring is ready, read by processes that attach.
+        std::atomic<uint64_t> magic;
+        /// The number of cells, a power of two.
+        uint64_t capacity;
+        /// The size of a cell.
+        uint64_t cell_size;
+        /// Keeps the indices away from the constants.
+        char padding0[64 - sizeof(std::atomic<uint64_t>) - 2 * sizeof(uint64_t)];
+        /// The index of the next name to remove.
+        std::atomic<uint64_t> head;
+        /// Keeps the indices in different cache lines.
+        char padding1[64 - sizeof(std::atomic<uint64_t>)];
+        /// The index of the next name to append.
+        std::atomic<uint64_t> tail;
+        /// Keeps the cells away from the indices.
+        char padding2[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    /// @brief A cell, the characters of the name follow it.
+    struct cell {
+        /// Tells whether the cell is ready for the producers or the consumers.
+        std::atomic<uint64_t> sequence;
+        /// The length of the name.
+        uint64_t length;
+
+        /// @brief Returns the characters of the name.
+        char *name()
+        {
+            return reinterpret_cast<char *>(this + 1);
+        }
+    };
+
+    /// @brief Returns the capacity rounded up to a power of two.
+    static std::size_t round_capacity(std::size_t capacity)
+    {
+        std::size_t result = 1;
+        while (result < capacity) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    /// @brief Returns the size of a cell, aligned to 8 bytes.
+    static std::size_t cell_size(std::size_t max_length)
+    {
+        return (sizeof(cell) + max_length + 1 + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    /// @brief Returns the cell of the given index.
+    cell *at(uint64_t position) const
+    {
+        return reinterpret_cast<cell *>(m_cells + (position & (m_header->capacity - 1)) * m_header->cell_size);
+    }
+
+    /// The state of the ring.
+    header *m_header;
+    /// The cells.
+    char *m_cells;
+};
+
+} // namespace detail
+
+} // namespace namegen
@@ -0,0 +1,307 @@
+/// @file registry.hpp
+/// @brief Hot reload of dictionaries and compiled patterns.
+/// @details
+/// A catalog bundles a dictionary with the patterns compiled against it. A
+/// registry publishes the current catalog through an atomic pointer: writers
+/// build a new catalog aside and swap it in, while readers keep using the
+/// catalog they started with, and never take a lock.
+///
+/// Replaced catalogs are reclaimed with epochs. Every reader pins the global
+/// epoch inside a slot for as long as it uses the catalog, and a catalog
+/// retired at epoch e is destroyed once no slot holds an epoch up to e. The
+/// number of slots bounds the number of concurrent readers, further readers
+/// spin until a slot is released.
+
+#pragma once
+
+#include "namegen/pattern.hpp"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// Maximum number of readers that can use a registry at the same time.
+#define NAME_REGISTRY_SLOTS 128
+
+namespace namegen
+{
+
+/// @brief A dictionary, and the patterns compiled against it.
+/// @details A catalog is not changed once it has been published.
+class catalog {
+public:
+    /// @brief Creates a catalog with the built-in tables and no patterns.
+    catalog()
+        : m_tables(),
+          m_sources(),
+          m_patterns()
+    {
+    }
+
+    /// @brief Creates a catalog with the given tables and no patterns.
+    /// @param tables the dictionary, it is copied.
+    explicit catalog(const dictionary &tables)
+        : m_tables(tables),
+          m_sources(),
+          m_patterns()
+    {
+    }
+
+    /// @brief Copies a catalog, recompiling its patterns against the copy of
+    /// the dictionary.
+    catalog(const catalog &other)
+        : m_tables(other.m_tables),
+          m_sources(other.m_sources),
+          m_patterns()
+    {
+        for (std::map<std::string, std::string>::const_iterator it = m_sources.begin(); it != m_sources.end(); ++it) {
+            compile(m_patterns[it->first], it->second, m_tables);
+        }
+    }
+
+    /// @brief Compiles a pattern, and binds it to a name, replacing the
+    /// previous one.
+    /// @param name the name of the pattern.
+    /// @param source the pattern.
+    /// @return the outcome of compile(), the catalog is unchanged on error.
+    return_code_t insert(const std::string &name, const std::string &source)
+    {
+        pattern compiled;
+        return_code_t ret = compile(compiled, source, m_tables);
+        if (ret == SUCCESS) {
+            m_sources[name]  = source;
+            m_patterns[name] = compiled;
+        }
+        return ret;
+    }
+
+    /// @brief Removes a pattern.
+    /// @param name the name of the pattern.
+    /// @return false if there is no such pattern.
+    bool erase(const std::string &name)
+    {
+        m_patterns.erase(name);
+        return m_sources.erase(name) > 0;
+    }
+
+    /// @brief Replaces the dictionary, and recompiles all the patterns.
+    /// @param tables the new dictionary, it is copied.
+    /// @return SUCCESS, or the first error of compile(), in which case the
+    /// catalog is unchanged.
+    return_code_t assign(const dictionary &tables)
+    {
+        for (std::map<std::string, std::string>::const_iterator it = m_sources.begin(); it != m_sources.end(); ++it) {
+            pattern compiled;
+            return_code_t ret = compile(compiled, it->second, tables);
+            if (ret != SUCCESS) {
+                return ret;
+            }
+        }
+        m_tables = tables;
+        for (std::map<std::string, std::string>::const_iterator it = m_sources.begin(); it != m_sources.end(); ++it) {
+            compile(m_patterns[it->first], it->second, m_tables);
+        }
+        return SUCCESS;
+    }
+
+    /// @brief Returns the pattern bound to a name.
+    /// @param name the name of the pattern.
+    /// @return the compiled pattern, or NULL if there is none.
+    const pattern *find(const std::string &name) const
+    {
+        std::map<std::string, pattern>::const_iterator it = m_patterns.find(name);
+        return (it == m_patterns.end()) ? NULL : &it->second;
+    }
+
+    /// @brief Returns the dictionary.
+    const dictionary &tables() const
+    {
+        return m_tables;
+    }
+
+private:
+    catalog &operator=(const catalog &);
+
+    /// The dictionary the patterns point into.
+    dictionary m_tables;
+    /// The source of each pattern.
+    std::map<std::string, std::string> m_sources;
+    /// The compiled patterns.
+    std::map<std::string, pattern> m_patterns;
+};
+
+/// @brief Publishes catalogs to concurrent readers.
+class registry {
+public:
+    /// @brief Pins the current catalog, for as long as it exists.
+    class reader {
+    public:
+        /// @brief Pins the current catalog of the given registry.
+        explicit reader(const registry &owner)
+            : m_slot(owner.acquire()),
+              m_catalog(owner.m_current.load())
+        {
+        }
+
+        /// @brief Releases the catalog.
+        ~reader()
+        {
+            m_slot->store(0);
+        }
+
+        /// @brief Returns the pinned catalog.
+        const catalog &get() const
+        {
+            return *m_catalog;
+        }
+
+        /// @brief Accesses the pinned catalog.
+        const catalog *operator->() const
+        {
+            return m_catalog;
+        }
+
+    private:
+        reader(const reader &);
+        reader &operator=(const reader &);
+
+        /// The slot holding the pinned epoch.
+        std::atomic<uint64_t> *m_slot;
+        /// The pinned catalog.
+        const catalog *m_catalog;
+    };
+
+    /// @brief Creates a registry publishing an empty catalog.
+    registry()
+        : m_current(new catalog()),
+          m_epoch(1),
+          m_version(0),
+          m_mutex(),
+          m_retired()
+    {
+        for (std::size_t i = 0; i < NAME_REGISTRY_SLOTS; ++i) {
+            m_slots[i].epoch.store(0);
+        }
+    }
+
+    /// @brief Destroys all the catalogs, no reader can be left.
+    ~registry()
+    {
+        delete m_current.load();
+        for (std::size_t i = 0; i < m_retired.size(); ++i) {
+            delete m_retired[i].second;
+        }
+    }
+
+    /// @brief Replaces the current catalog. Readers that pinned the previous
+    /// one keep using it, and it is destroyed after the last of them is gone.
+    /// @param next the new catalog, the registry takes ownership of it.
+    void publish(std::unique_ptr<catalog> next)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const catalog *previous = m_current.exchange(next.release());
+        m_retired.push_back(std::make_pair(m_epoch.fetch_add(1), previous));
+        m_version.fetch_add(1);
+        this->collect();
+    }
+
+    /// @brief Destroys the replaced catalogs which no reader uses anymore.
+    /// @return the number of replaced catalogs still in use.
+    std::size_t reclaim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return this->collect();
+    }
+
+    /// @brief Returns the number of catalogs published so far.
+    uint64_t version() const
+    {
+        return m_version.load();
+    }
+
+private:
+    registry(const registry &);
+    registry &operator=(const registry &);
+
+    /// @brief A reader slot, alone in its cache line.
+    struct slot {
+        /// The pinned epoch, 0 if the slot is free.
+        std::atomic<uint64_t> epoch;
+        /// Keeps the next slot away.
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    /// @brief Claims a free slot, and pins the current epoch in it.
+    std::atomic<uint64_t> *acquire() const
+    {
+        std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+        for (;;) {
+            for (std::size_t i = 0; i < NAME_REGISTRY_SLOTS; ++i) {
+                std::atomic<uint64_t> &epoch = m_slots[(start + i) % NAME_REGISTRY_SLOTS].epoch;
+                uint64_t expected            = 0;
+                if ((epoch.load(std::memory_order_relaxed) == 0) && epoch.compare_exchange_strong(expected, m_epoch.load())) {
+                    return &epoch;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    /// @brief Destroys the replaced catalogs which no reader uses anymore,
+    /// with the mutex held.
+    std::size_t collect()
+    {
+        uint64_t oldest = m_epoch.load();
+        for (std::size_t i = 0; i < NAME_REGISTRY_SLOTS; ++i) {
+            uint64_t epoch = m_slots[i].epoch.load();
+            if ((epoch != 0) && (epoch < oldest)) {
+                oldest = epoch;
+            }
+        }
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < m_retired.size(); ++i) {
+            if (m_retired[i].first < oldest) {
+                delete m_retired[i].second;
+            } else {
+                m_retired[kept++] = m_retired[i];
+            }
+        }
+        m_retired.resize(kept);
+        return kept;
+    }
+
+    /// The current catalog.
+    std::atomic<const catalog *> m_current;
+    /// The global epoch, it advances at every publication.
+    std::atomic<uint64_t> m_epoch;
+    /// The number of publications.
+    std::atomic<uint64_t> m_version;
+    /// Serializes the writers.
+    std::mutex m_mutex;
+    /// The replaced catalogs, with the epoch they were retired at.
+    std::vector<std::pair<uint64_t, const catalog *> > m_retired;
+    /// The reader slots.
+    mutable slot m_slots[NAME_REGISTRY_SLOTS];
+};
+
+/// @brief Generate a random name with one of the patterns of the current
+/// catalog of a registry.
+/// @param buffer the string where the name is placed.
+/// @param patterns the registry.
+/// @param name the name of the pattern.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, or INVALID if the catalog has no such pattern.
+inline return_code_t generate(std::string &buffer, const registry &patterns, const std::string &name, uint64_t &seed)
+{
+    registry::reader current(patterns);
+    const pattern *compiled = current->find(name);
+    if (!compiled) {
+        buffer.clear();
+        return INVALID;
+    }
+    return generate(buffer, *compiled, seed);
+}
+
+} // namespace namegen
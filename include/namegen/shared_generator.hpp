@@ -0,0 +1,159 @@
+/// @file shared_generator.hpp
+/// @brief A generator that many threads can call at the same time.
+/// @details
+/// generate() advances the seed it is given, so sharing one seed between
+/// threads needs a lock. A shared_generator uses a counter-based stream
+/// instead: name number n is generated from a seed derived from the key of
+/// the generator and from n alone, and threads claim counters with a single
+/// atomic fetch_add. No two calls ever get the same counter, nothing else is
+/// shared, and every name can be generated again from its (key, counter) pair,
+/// as long as the engine of the pattern is not changed to ENGINE_TABLE, which
+/// draws a different stream (see engine.hpp).
+
+#pragma once
+
+#include "namegen/arena.hpp"
+
+#include <atomic>
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Scrambles a 64-bit value (the finalizer of SplitMix64).
+/// @param value the value.
+/// @return the scrambled value.
+inline uint64_t mix(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/// @brief Returns the seed of an element of a counter-based stream.
+/// @details The generator only ever draws from the low 32 bits of the seed,
+/// the high ones never reach them, so the effective seed space is 2^32: two
+/// counters whose seeds share the low 32 bits give the same name.
+/// @param key the key of the stream.
+/// @param counter the index of the element.
+/// @return a seed whose low 32 bits are never all zero, since the generator
+/// would get stuck on them.
+inline uint64_t stream_seed(uint64_t key, uint64_t counter)
+{
+    uint64_t seed = mix(mix(key) ^ counter);
+    return (seed & 0xffffffffULL) ? seed : (seed | 0x7f4a7c15ULL);
+}
+
+} // namespace detail
+
+/// @brief Generates names from a compiled pattern, concurrently.
+class shared_generator {
+public:
+    /// @brief Creates a generator.
+    /// @param compiled the compiled pattern, which must outlive the generator.
+    /// @param key the key of the stream.
+    /// @param counter the first counter handed out.
+    shared_generator(const pattern &compiled, uint64_t key, uint64_t counter = 0)
+        : m_pattern(&compiled),
+          m_key(key),
+          m_counter(counter)
+    {
+    }
+
+    /// @brief Returns the key of the stream.
+    uint64_t key() const
+    {
+        return m_key;
+    }
+
+    /// @brief Returns the next counter to be handed out.
+    uint64_t counter() const
+    {
+        return m_counter.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Claims a range of counters, which no other call gets.
+    /// @param count the number of counters.
+    /// @return the first counter of the range.
+    uint64_t reserve(uint64_t count)
+    {
+        return m_counter.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /// @brief Generates the name with the given counter, again.
+    /// @param buffer the string where the name is placed.
+    /// @param counter the counter of the name.
+    /// @return the same codes of generate().
+    return_code_t at(std::string &buffer, uint64_t counter) const
+    {
+        uint64_t seed = detail::stream_seed(m_key, counter);
+        return generate(buffer, *m_pattern, seed);
+    }
+
+    /// @brief Generates the names of a range of counters, appending them to an
+    /// arena.
+    /// @param arena the arena where the names are placed.
+    /// @param first the first counter.
+    /// @param count the number of names.
+    /// @return the same codes of generate().
+    return_code_t at(name_arena &arena, uint64_t first, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            uint64_t seed     = detail::stream_seed(m_key, first + i);
+            return_code_t ret = generate(arena, *m_pattern, 1, seed);
+            if (ret != SUCCESS) {
+                return ret;
+            }
+        }
+        return SUCCESS;
+    }
+
+private:
+    shared_generator(const shared_generator &);
+    shared_generator &operator=(const shared_generator &);
+
+    /// The compiled pattern.
+    const pattern *m_pattern;
+    /// The key of the stream.
+    uint64_t m_key;
+    /// The next counter to be handed out.
+    std::atomic<uint64_t> m_counter;
+};
+
+/// @brief Generate a random name with the next counter of a shared generator.
+/// Safe to call from many threads at once.
+/// @param buffer the string where the name is placed.
+/// @param generator the generator.
+/// @param counter if not NULL, receives the counter of the name.
+/// @return the same codes of generate().
+inline return_code_t generate(std::string &buffer, shared_generator &generator, uint64_t *counter = NULL)
+{
+    uint64_t claimed = generator.reserve(1);
+    if (counter) {
+        *counter = claimed;
+    }
+    return generator.at(buffer, claimed);
+}
+
+/// @brief Generate a batch of random names with consecutive counters of a
+/// shared generator, appending them to an arena. Safe to call from many
+/// threads at once, with different arenas.
+/// @param arena the arena where the names are placed.
+/// @param generator the generator.
+/// @param count the number of names.
+/// @param first if not NULL, receives the counter of the first name.
+/// @return the same codes of generate().
+inline return_code_t generate(name_arena &arena, shared_generator &generator, std::size_t count, uint64_t *first = NULL)
+{
+    uint64_t claimed = generator.reserve(count);
+    if (first) {
+        *first = claimed;
+    }
+    return generator.at(arena, claimed, count);
+}
+
+} // namespace namegen
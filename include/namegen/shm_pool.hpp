@@ -0,0 +1,264 @@
+/// @file shm_pool.hpp
+/// @brief Unique names shared between processes through POSIX shared memory.
+/// @details
+/// One producer process owns the generator and the set of names handed out so
+/// far. It generates names in batches into an arena, drops the ones it has
+/// already produced, and pushes the others inside a ring stored in a POSIX
+/// shared memory object. Any number of consumer processes attach to the same
+/// object, and pop names without locks and without system calls.
+///
+/// The producer remembers the 64-bit hash of every name it produced, hence
+/// names are unique up to hash collisions. Where shm_open() lives outside the
+/// C library (glibc before 2.34), programs must link against librt.
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include "namegen/arena.hpp"
+#include "namegen/queue.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief A POSIX shared memory object, mapped in memory.
+class shared_block {
+public:
+    /// @brief Creates a new object, replacing any previous one with the same
+    /// name, or opens an existing one.
+    /// @param name the name of the object, starting with a slash.
+    /// @param size the size of the object, 0 to open an existing one.
+    shared_block(const std::string &name, std::size_t size)
+        : m_name(name),
+          m_data(NULL),
+          m_size(0),
+          m_owner(size > 0)
+    {
+        if (m_owner) {
+            ::shm_unlink(name.c_str());
+        }
+        int fd = ::shm_open(name.c_str(), m_owner ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (m_owner ? (::ftruncate(fd, static_cast<off_t>(size)) == 0) : ((::fstat(fd, &info) == 0) && (info.st_size > 0))) {
+            size        = m_owner ? size : static_cast<std::size_t>(info.st_size);
+            void *data  = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = data;
+                m_size = size;
+            }
+        }
+        ::close(fd);
+    }
+
+    /// @brief Unmaps the object, and removes it if it was created here.
+    ~shared_block()
+    {
+        if (m_data) {
+            ::munmap(m_data, m_size);
+        }
+        if (m_owner) {
+            ::shm_unlink(m_name.c_str());
+        }
+    }
+
+    /// @brief Returns the mapped memory, NULL on failure.
+    void *data() const
+    {
+        return m_data;
+    }
+
+    /// @brief Returns the size of the object.
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    shared_block(const shared_block &);
+    shared_block &operator=(const shared_block &);
+
+    /// The name of the object.
+    std::string m_name;
+    /// The mapped memory.
+    void *m_data;
+    /// The size of the object.
+    std::size_t m_size;
+    /// If the object was created here.
+    bool m_owner;
+};
+
+} // namespace detail
+
+/// @brief Produces unique names inside a shared memory object.
+class shm_producer {
+public:
+    /// @brief Creates the shared memory object.
+    /// @param name the name of the object, starting with a slash, e.g.
+    /// "/namegen-orcs".
+    /// @param compiled the compiled pattern, which must outlive the producer.
+    /// @param seed the seed of the generator.
+    /// @param capacity the number of names the object holds.
+    /// @param max_length the maximum length of a name, longer ones are dropped.
+    shm_producer(const std::string &name, const pattern &compiled, uint64_t seed, std::size_t capacity = 4096, std::size_t max_length = 63)
+        : m_block(name, detail::name_ring::footprint(capacity, max_length)),
+          m_ring(),
+          m_pattern(&compiled),
+          m_seed(seed),
+          m_arena(),
+          m_next(0),
+          m_seen(),
+          m_status(SUCCESS)
+    {
+        if (m_block.data() && !m_ring.create(m_block.data(), capacity, max_length)) {
+            m_ring = detail::name_ring();
+        }
+    }
+
+    /// @brief Returns true if the object was created.
+    bool valid() const
+    {
+        return m_ring.valid();
+    }
+
+    /// @brief Returns the number of names inside the object.
+    std::size_t size() const
+    {
+        return m_ring.size();
+    }
+
+    /// @brief Returns the number of distinct names produced so far.
+    std::size_t produced() const
+    {
+        return m_seen.size();
+    }
+
+    /// @brief Returns the outcome of the last generation, e.g. INVALID if the
+    /// pattern was never compiled, in which case fill() pushes nothing.
+    return_code_t status() const
+    {
+        return m_status;
+    }
+
+    /// @brief Pushes new names until the object is full.
+    /// @param batch the number of names generated at once, nothing is pushed
+    /// if it is 0.
+    /// @param attempts the maximum number of names generated, duplicates
+    /// included, before giving up on a pattern running out of names.
+    /// @return the number of names pushed, status() tells if generation
+    /// failed.
+    std::size_t fill(std::size_t batch = 256, std::size_t attempts = 1000000)
+    {
+        std::size_t pushed = 0;
+        if (batch == 0) {
+            return pushed;
+        }
+        for (std::size_t generated = 0; this->valid();) {
+            if (m_next == m_arena.size()) {
+                if (generated >= attempts) {
+                    break;
+                }
+                m_arena.clear();
+                m_next = 0;
+                m_status = generate(m_arena, *m_pattern, batch, m_seed);
+                if (m_status != SUCCESS) {
+                    break;
+                }
+                generated += batch;
+            }
+            for (; m_next < m_arena.size(); ++m_next) {
+                const char *current = m_arena.name(m_next);
+                std::size_t length  = m_arena.length(m_next);
+                if ((length > m_ring.max_length()) || m_seen.count(hash(current, length))) {
+                    continue;
+                }
+                if (!m_ring.push(current, length)) {
+                    // Full, the name waits for the next call.
+                    return pushed;
+                }
+                m_seen.insert(hash(current, length));
+                ++pushed;
+            }
+        }
+        return pushed;
+    }
+
+private:
+    /// @brief Hashes a name (64-bit FNV-1a).
+    static uint64_t hash(const char *name, std::size_t length)
+    {
+        uint64_t result = 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < length; ++i) {
+            result = (result ^ static_cast<unsigned char>(name[i])) * 0x100000001b3ULL;
+        }
+        return result;
+    }
+
+    /// The shared memory object.
+    detail::shared_block m_block;
+    /// The ring inside the object.
+    detail::name_ring m_ring;
+    /// The compiled pattern.
+    const pattern *m_pattern;
+    /// The seed of the generator.
+    uint64_t m_seed;
+    /// The last batch of names.
+    name_arena m_arena;
+    /// The next name of the batch to push.
+    std::size_t m_next;
+    /// The hashes of the names produced so far.
+    std::unordered_set<uint64_t> m_seen;
+    /// The outcome of the last generation.
+    return_code_t m_status;
+};
+
+/// @brief Consumes the names of a shm_producer, possibly from another process.
+class shm_consumer {
+public:
+    /// @brief Opens the shared memory object.
+    /// @param name the name of the object, as given to the producer.
+    explicit shm_consumer(const std::string &name)
+        : m_block(name, 0),
+          m_ring()
+    {
+        if (m_block.data() && !m_ring.attach(m_block.data(), m_block.size())) {
+            m_ring = detail::name_ring();
+        }
+    }
+
+    /// @brief Returns true if the object was opened.
+    bool valid() const
+    {
+        return m_ring.valid();
+    }
+
+    /// @brief Takes a name.
+    /// @param buffer the string where the name is placed.
+    /// @return false if there are no names left, or the object is not valid.
+    bool pop(std::string &buffer)
+    {
+        return this->valid() && m_ring.pop(buffer);
+    }
+
+private:
+    /// The shared memory object.
+    detail::shared_block m_block;
+    /// The ring inside the object.
+    detail::name_ring m_ring;
+};
+
+} // namespace namegen
+
+#endif
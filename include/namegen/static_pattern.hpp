@@ -0,0 +1,449 @@
+/// @file static_pattern.hpp
+/// @brief Patterns parsed and validated at compile time (C++20).
+/// @details
+/// A static_pattern takes its pattern as a template argument:
+///
+///     namegen::static_pattern<"!BVC(ith)"> elf;
+///     namegen::generate(buffer, elf, seed);
+///
+/// The pattern is parsed into a tree while compiling, and a malformed one is
+/// a compilation error. The generator is a chain of templates that follows the
+/// tree, so the compiler sees every group and every token of the pattern, and
+/// inlines the whole of it, with no tree left to walk at run time.
+///
+/// The names, and the numbers drawn, are the ones of the single-pass
+/// generate() with the same pattern and seed, weights included. Tokens come
+/// from the built-in tables.
+///
+/// With a constant seed, the name itself is computed by the compiler, and
+/// only its characters end up in the program:
+///
+///     constexpr auto name = namegen::static_pattern<"!BVC(ith)">::name<42>;
+///     static_assert(name.size() > 3);
+
+#pragma once
+
+#if __cplusplus >= 202002L
+
+#include "namegen/pattern.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+namespace namegen
+{
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief A string usable as a template argument.
+template <std::size_t N>
+struct fixed_string {
+    /// The characters, followed by a zero.
+    char data[N];
+
+    /// @brief Copies a string literal.
+    constexpr fixed_string(const char (&source)[N])
+        : data()
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            data[i] = source[i];
+        }
+    }
+
+    /// @brief Returns the length of the string.
+    constexpr std::size_t size() const
+    {
+        return N - 1;
+    }
+};
+
+/// @brief Marks the end of a list of the static tree.
+constexpr std::size_t static_none = static_cast<std::size_t>(-1);
+
+/// @brief An element of an alternative of a static tree.
+struct static_item {
+    /// The kind of item.
+    pattern::item_kind_t kind;
+    /// The key of a token, or the character of a literal.
+    char value;
+    /// The index of a nested group.
+    std::size_t group;
+    /// The index of the next item of the alternative.
+    std::size_t next;
+};
+
+/// @brief An option of a group of a static tree.
+struct static_alternative {
+    /// The index of the first item.
+    std::size_t first;
+    /// The index of the next alternative of the group.
+    std::size_t next;
+    /// Effect on the capitalization flag when the alternative is skipped.
+    pattern::effect_t effect;
+    /// The weight of the alternative, 1 if it has none.
+    uint64_t weight;
+};
+
+/// @brief A pattern parsed at compile time. Items and alternatives are linked
+/// lists, in the order they appear in the pattern.
+/// @details A pattern of N characters has at most N items, N + 1 alternatives
+/// and N + 1 groups, the root included.
+template <std::size_t N>
+struct static_tree {
+    /// The outcome of the validation.
+    return_code_t status;
+    /// The items.
+    static_item items[N + 1];
+    /// The alternatives.
+    static_alternative alternatives[N + 1];
+    /// The first alternative of every group.
+    std::size_t groups[N + 1];
+};
+
+/// @brief Tells if a key has a built-in table, at compile time.
+constexpr bool is_builtin_key(char key)
+{
+    for (const char *keys = "svVcBCimMDd"; *keys; ++keys) {
+        if (*keys == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Returns the length of the weight starting at the given position,
+/// like get_weight_length(), at compile time.
+template <std::size_t N>
+constexpr std::size_t get_static_weight_length(const fixed_string<N> &source, std::size_t position)
+{
+    std::size_t end = position + 1;
+    while ((end < source.size()) && (source.data[end] >= '0') && (source.data[end] <= '9')) {
+        ++end;
+    }
+    if ((end == position + 1) || (end > position + 10)) {
+        return 0;
+    }
+    if ((end < source.size()) && (source.data[end] != '|') && (source.data[end] != '>') && (source.data[end] != ')')) {
+        return 0;
+    }
+    return end - position;
+}
+
+/// @brief Parses a pattern into a static tree, reporting the same errors as
+/// the single-pass generator.
+template <std::size_t N>
+constexpr static_tree<N> parse_static(const fixed_string<N> &source)
+{
+    static_tree<N> tree{};
+    tree.status = SUCCESS;
+    // The open groups: their kind, their last alternative and last item.
+    bool literal[NAME_MAX_DEPTH]{};
+    std::size_t alternative[NAME_MAX_DEPTH]{};
+    std::size_t last[NAME_MAX_DEPTH]{};
+    std::size_t items = 0, alternatives = 1, groups = 1, depth = 0;
+    tree.groups[0]       = 0;
+    tree.alternatives[0] = static_alternative{ static_none, static_none, pattern::EFFECT_KEEP, 1 };
+    last[0]              = static_none;
+    for (std::size_t position = 0; position < source.size(); ++position) {
+        char c = source.data[position];
+        if ((c == '>') || (c == ')')) {
+            if ((depth == 0) || (literal[depth] != (c == ')'))) {
+                tree.status = INVALID;
+                return tree;
+            }
+            --depth;
+            continue;
+        }
+        if (c == '|') {
+            tree.alternatives[alternative[depth]].next = alternatives;
+            tree.alternatives[alternatives]            = static_alternative{ static_none, static_none, pattern::EFFECT_KEEP, 1 };
+            alternative[depth]                         = alternatives++;
+            last[depth]                                = static_none;
+            continue;
+        }
+        if (!literal[depth] && (c == ':') && get_static_weight_length(source, position)) {
+            uint64_t weight = 0;
+            std::size_t end = position + get_static_weight_length(source, position);
+            while (++position < end) {
+                weight = weight * 10 + static_cast<uint64_t>(source.data[position] - '0');
+            }
+            tree.alternatives[alternative[depth]].weight = weight;
+            --position;
+            continue;
+        }
+        static_item item{ pattern::ITEM_LITERAL, c, 0, static_none };
+        if ((c == '<') || (c == '(')) {
+            item.kind  = pattern::ITEM_GROUP;
+            item.group = groups;
+        } else if (c == '!') {
+            item.kind = pattern::ITEM_CAPITALIZE;
+        } else if (!literal[depth] && is_builtin_key(c)) {
+            item.kind = pattern::ITEM_TOKEN;
+        }
+        // Skipping the item changes the flag of all the open alternatives.
+        if (item.kind != pattern::ITEM_GROUP) {
+            for (std::size_t i = 0; i <= depth; ++i) {
+                tree.alternatives[alternative[i]].effect = (c == '!') ? pattern::EFFECT_SET : pattern::EFFECT_CLEAR;
+            }
+        }
+        if (last[depth] == static_none) {
+            tree.alternatives[alternative[depth]].first = items;
+        } else {
+            tree.items[last[depth]].next = items;
+        }
+        last[depth]         = items;
+        tree.items[items++] = item;
+        if (item.kind == pattern::ITEM_GROUP) {
+            if (++depth == NAME_MAX_DEPTH) {
+                tree.status = TOO_DEEP;
+                return tree;
+            }
+            literal[depth]                  = (c == '(');
+            tree.groups[groups++]           = alternatives;
+            tree.alternatives[alternatives] = static_alternative{ static_none, static_none, pattern::EFFECT_KEEP, 1 };
+            alternative[depth]              = alternatives++;
+            last[depth]                     = static_none;
+        }
+    }
+    if (depth) {
+        tree.status = INVALID;
+    }
+    return tree;
+}
+
+/// @brief The built-in tokens of a key.
+struct static_tokens {
+    /// The tokens.
+    const char *const *tokens;
+    /// The number of tokens.
+    std::size_t count;
+};
+
+/// @brief Returns the built-in tokens of a key, at compile time.
+constexpr static_tokens get_static_tokens(char key)
+{
+    switch (key) {
+    case 's': return { builtin_tokens<>::s, std::size(builtin_tokens<>::s) };
+    case 'v': return { builtin_tokens<>::v, std::size(builtin_tokens<>::v) };
+    case 'V': return { builtin_tokens<>::V, std::size(builtin_tokens<>::V) };
+    case 'c': return { builtin_tokens<>::c, std::size(builtin_tokens<>::c) };
+    case 'B': return { builtin_tokens<>::B, std::size(builtin_tokens<>::B) };
+    case 'C': return { builtin_tokens<>::C, std::size(builtin_tokens<>::C) };
+    case 'i': return { builtin_tokens<>::i, std::size(builtin_tokens<>::i) };
+    case 'm': return { builtin_tokens<>::m, std::size(builtin_tokens<>::m) };
+    case 'M': return { builtin_tokens<>::M, std::size(builtin_tokens<>::M) };
+    case 'D': return { builtin_tokens<>::D, std::size(builtin_tokens<>::D) };
+    case 'd': return { builtin_tokens<>::d, std::size(builtin_tokens<>::d) };
+    default: return { nullptr, 0 };
+    }
+}
+
+/// @brief Returns the maximum length of the names of a group of a static tree.
+template <std::size_t N>
+constexpr std::size_t get_static_length(const static_tree<N> &tree, std::size_t group)
+{
+    std::size_t result = 0;
+    for (std::size_t i = tree.groups[group]; i != static_none; i = tree.alternatives[i].next) {
+        std::size_t length = 0;
+        for (std::size_t j = tree.alternatives[i].first; j != static_none; j = tree.items[j].next) {
+            const static_item &item = tree.items[j];
+            if (item.kind == pattern::ITEM_TOKEN) {
+                static_tokens table = get_static_tokens(item.value);
+                std::size_t longest = 0;
+                for (std::size_t k = 0; k < table.count; ++k) {
+                    longest = std::max(longest, std::char_traits<char>::length(table.tokens[k]));
+                }
+                length += longest;
+            } else if (item.kind == pattern::ITEM_LITERAL) {
+                ++length;
+            } else if (item.kind == pattern::ITEM_GROUP) {
+                length += get_static_length(tree, item.group);
+            }
+        }
+        result = std::max(result, length);
+    }
+    return result;
+}
+
+/// @brief Returns a built-in table, looked up once.
+template <char Key>
+inline const token_table &get_static_table()
+{
+    static const token_table &table = *get_table(Key);
+    return table;
+}
+
+} // namespace detail
+
+/// @brief A name generated at compile time.
+/// @tparam N the maximum length of the name.
+template <std::size_t N>
+struct static_name {
+    /// The characters, followed by a zero.
+    char data[N + 1];
+    /// The length of the name.
+    std::size_t length;
+
+    /// @brief Returns the name, terminated by a zero.
+    constexpr const char *c_str() const
+    {
+        return data;
+    }
+
+    /// @brief Returns the length of the name.
+    constexpr std::size_t size() const
+    {
+        return length;
+    }
+};
+
+/// @brief A pattern given as a template argument, parsed at compile time.
+/// @tparam Source the pattern.
+template <detail::fixed_string Source>
+class static_pattern {
+public:
+    /// The parsed pattern.
+    static constexpr detail::static_tree<sizeof(Source.data)> tree = detail::parse_static(Source);
+
+    static_assert(tree.status != TOO_DEEP, "the pattern exceeds NAME_MAX_DEPTH");
+    static_assert(tree.status == SUCCESS, "the pattern has unbalanced brackets");
+
+    /// The maximum length of the names.
+    static constexpr std::size_t max_length = detail::get_static_length(tree, 0);
+
+    /// @brief Returns the pattern.
+    static constexpr const char *source()
+    {
+        return Source.data;
+    }
+
+    /// @brief Generate a random name, at compile time when the seed is a
+    /// constant.
+    /// @param seed the seed used for random number generation.
+    /// @return the name.
+    static constexpr static_name<max_length> make(uint64_t &seed)
+    {
+        static_name<max_length> result{};
+        bool capitalize = false;
+        run_group<0>(result.data, result.length, capitalize, seed);
+        result.data[result.length] = 0;
+        return result;
+    }
+
+    /// The name generated from a seed, at compile time.
+    template <uint64_t Seed>
+    static constexpr static_name<max_length> name = [] {
+        uint64_t seed = Seed;
+        return static_pattern::make(seed);
+    }();
+
+    /// @brief Generate a random name.
+    /// @param buffer the string where the name is placed.
+    /// @param seed the seed used for random number generation.
+    static void run(std::string &buffer, uint64_t &seed)
+    {
+        char name[max_length + 1];
+        std::size_t location = 0;
+        bool capitalize      = false;
+        run_group<0>(name, location, capitalize, seed);
+        buffer.assign(name, location);
+    }
+
+private:
+    /// @brief Generates a group, with the reservoir sampling of the
+    /// single-pass generator.
+    template <std::size_t Group>
+    static constexpr void run_group(char *buffer, std::size_t &location, bool &capitalize, uint64_t &seed)
+    {
+        constexpr std::size_t first = tree.groups[Group];
+        std::size_t reset           = location;
+        bool entry                  = capitalize;
+        run_items<tree.alternatives[first].first>(buffer, location, capitalize, seed);
+        run_alternatives<tree.alternatives[first].next>(buffer, location, capitalize, seed, reset, entry, tree.alternatives[first].weight);
+    }
+
+    /// @brief Gives the alternatives after the first one of a group their
+    /// chance of replacing the current selection.
+    template <std::size_t Alternative>
+    static constexpr void run_alternatives(
+        char *buffer,
+        std::size_t &location,
+        bool &capitalize,
+        uint64_t &seed,
+        std::size_t reset,
+        bool entry,
+        uint64_t total)
+    {
+        if constexpr (Alternative != detail::static_none) {
+            constexpr detail::static_alternative alternative = tree.alternatives[Alternative];
+            total += alternative.weight;
+            if (detail::get_rand(seed) < detail::get_threshold(alternative.weight, total)) {
+                // Switch to this option.
+                location   = reset;
+                capitalize = entry;
+                run_items<alternative.first>(buffer, location, capitalize, seed);
+            } else if constexpr (alternative.effect != pattern::EFFECT_KEEP) {
+                // Skip this option.
+                capitalize = (alternative.effect == pattern::EFFECT_SET);
+            }
+            run_alternatives<alternative.next>(buffer, location, capitalize, seed, reset, entry, total);
+        }
+    }
+
+    /// @brief Generates the items of an alternative, from the given one on.
+    template <std::size_t Item>
+    static constexpr void run_items(char *buffer, std::size_t &location, bool &capitalize, uint64_t &seed)
+    {
+        if constexpr (Item != detail::static_none) {
+            constexpr detail::static_item item = tree.items[Item];
+            if constexpr (item.kind == pattern::ITEM_TOKEN) {
+                if (std::is_constant_evaluated()) {
+                    constexpr detail::static_tokens table = detail::get_static_tokens(item.value);
+                    const char *token = table.tokens[detail::get_rand<std::size_t>(seed, 0, table.count)];
+                    for (; *token; ++token) {
+                        buffer[location++] = detail::get_capitalized(*token, capitalize);
+                        capitalize         = false;
+                    }
+                } else {
+                    const token_table &table = detail::get_static_table<item.value>();
+                    std::size_t select       = table.select(seed);
+                    std::size_t length       = table.length(select);
+                    std::memcpy(buffer + location, table.token(select), length);
+                    if (capitalize) {
+                        detail::capitalize_token(buffer + location, length);
+                    }
+                    location += length;
+                }
+                capitalize = false;
+            } else if constexpr (item.kind == pattern::ITEM_LITERAL) {
+                buffer[location++] = detail::get_capitalized(item.value, capitalize);
+                capitalize         = false;
+            } else if constexpr (item.kind == pattern::ITEM_CAPITALIZE) {
+                capitalize = true;
+            } else {
+                run_group<item.group>(buffer, location, capitalize, seed);
+            }
+            run_items<item.next>(buffer, location, capitalize, seed);
+        }
+    }
+};
+
+/// @brief Generate a random name based on a static pattern and a given seed,
+/// and saves it into buffer.
+/// @param buffer the string where the name is placed.
+/// @param seed the seed used for random number generation.
+/// @return SUCCESS, the pattern was validated at compile time.
+template <detail::fixed_string Source>
+inline return_code_t generate(std::string &buffer, const static_pattern<Source> &, uint64_t &seed)
+{
+    static_pattern<Source>::run(buffer, seed);
+    return SUCCESS;
+}
+
+} // namespace namegen
+
+#endif
@@ -0,0 +1,335 @@
+/// @file table.hpp
+/// @brief Token tables with per-token weights.
+/// @details
+/// A token table packs all its tokens inside a single pool of characters, each
+/// one followed by a terminator, next to the arrays of their offsets, lengths
+/// and weights. Tables whose tokens all weigh the same are sampled exactly like
+/// the single-pass generator does, with `get_rand() % count`. Otherwise, they
+/// keep an alias table, and select a token with a single draw, so designers can
+/// make some tokens more frequent without repeating them inside the table.
+///
+/// A table either owns its arrays, or views arrays stored elsewhere, like
+/// inside a memory-mapped dictionary file (see binary.hpp). Changing a view
+/// first copies its arrays.
+
+#pragma once
+
+#include "namegen/alias.hpp"
+#include "namegen/namegen.hpp"
+
+#include <vector>
+
+namespace namegen
+{
+
+/// @brief A table of weighted tokens, stored in a packed pool.
+class token_table {
+public:
+    /// @brief Creates an empty table.
+    token_table()
+        : m_pool(),
+          m_offsets(),
+          m_lengths(),
+          m_weights(),
+          m_alias(),
+          m_view()
+    {
+    }
+
+    /// @brief Copies one of the built-in tables, with all the weights set to 1.
+    /// @param key the key of the built-in table, the table is empty if there is
+    /// no such table.
+    explicit token_table(int key)
+        : m_pool(),
+          m_offsets(),
+          m_lengths(),
+          m_weights(),
+          m_alias(),
+          m_view()
+    {
+        const char *const *tokens;
+        std::size_t count = detail::get_tokens(key, tokens);
+        for (std::size_t i = 0; i < count; ++i) {
+            this->append(tokens[i], detail::get_strlen(tokens[i]), 1);
+        }
+        this->update();
+    }
+
+    /// @brief Creates a table from a list of tokens.
+    /// @param tokens the tokens.
+    /// @param weights the weights of the tokens, missing ones are set to 1.
+    explicit token_table(const std::vector<std::string> &tokens, const std::vector<uint32_t> &weights = std::vector<uint32_t>())
+        : m_pool(),
+          m_offsets(),
+          m_lengths(),
+          m_weights(),
+          m_alias(),
+          m_view()
+    {
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            this->append(tokens[i].c_str(), tokens[i].size(), (i < weights.size()) ? weights[i] : 1);
+        }
+        this->update();
+    }
+
+    /// @brief Copies a table, a copy of a view is a view of the same arrays.
+    token_table(const token_table &other)
+        : m_pool(other.m_pool),
+          m_offsets(other.m_offsets),
+          m_lengths(other.m_lengths),
+          m_weights(other.m_weights),
+          m_alias(other.m_alias),
+          m_view(other.m_view)
+    {
+        if (other.owned()) {
+            this->bind();
+        }
+    }
+
+    /// @brief Copies a table, a copy of a view is a view of the same arrays.
+    token_table &operator=(const token_table &other)
+    {
+        if (this != &other) {
+            m_pool    = other.m_pool;
+            m_offsets = other.m_offsets;
+            m_lengths = other.m_lengths;
+            m_weights = other.m_weights;
+            m_alias   = other.m_alias;
+            m_view    = other.m_view;
+            if (other.owned()) {
+                this->bind();
+            }
+        }
+        return *this;
+    }
+
+    /// @brief The arrays of a table, as stored inside the pool layout.
+    struct layout {
+        /// The tokens, each one followed by a zero.
+        const char *pool;
+        /// Where each token starts inside the pool.
+        const uint32_t *offsets;
+        /// The length of each token.
+        const uint32_t *lengths;
+        /// The weight of each token.
+        const uint32_t *weights;
+        /// The alias table, NULL if all the tokens weigh the same.
+        const alias_entry *alias;
+        /// The number of tokens.
+        std::size_t size;
+        /// The size of the pool, terminators included.
+        std::size_t pool_size;
+        /// The sum of the weights.
+        uint64_t total;
+    };
+
+    /// @brief Creates a table viewing arrays stored elsewhere, which must
+    /// outlive it and all its copies.
+    /// @param arrays the arrays.
+    /// @return the view.
+    static token_table view(const layout &arrays)
+    {
+        token_table table;
+        table.m_view = arrays;
+        return table;
+    }
+
+    /// @brief Returns the arrays of the table.
+    const layout &arrays() const
+    {
+        return m_view;
+    }
+
+    /// @brief Appends a token, and rebuilds the alias table if needed.
+    /// @param token the token.
+    /// @param weight the weight of the token.
+    void insert(const std::string &token, uint32_t weight = 1)
+    {
+        this->own();
+        this->append(token.c_str(), token.size(), weight);
+        this->update();
+    }
+
+    /// @brief Changes the weight of every occurrence of a token.
+    /// @param token the token.
+    /// @param weight the new weight.
+    /// @return false if the table does not contain the token.
+    bool set_weight(const std::string &token, uint32_t weight)
+    {
+        this->own();
+        bool found = false;
+        for (std::size_t i = 0; i < this->size(); ++i) {
+            if (token.compare(this->token(i)) == 0) {
+                m_weights[i] = weight;
+                found        = true;
+            }
+        }
+        if (found) {
+            this->update();
+        }
+        return found;
+    }
+
+    /// @brief Returns the number of tokens.
+    std::size_t size() const
+    {
+        return m_view.size;
+    }
+
+    /// @brief Returns true if the table contains no tokens.
+    bool empty() const
+    {
+        return m_view.size == 0;
+    }
+
+    /// @brief Returns the token at the given index, terminated by a zero.
+    const char *token(std::size_t index) const
+    {
+        return m_view.pool + m_view.offsets[index];
+    }
+
+    /// @brief Returns the length of the token at the given index.
+    std::size_t length(std::size_t index) const
+    {
+        return m_view.lengths[index];
+    }
+
+    /// @brief Returns the weight of the token at the given index.
+    uint32_t weight(std::size_t index) const
+    {
+        return m_view.weights[index];
+    }
+
+    /// @brief Returns true if the tokens do not all weigh the same.
+    bool weighted() const
+    {
+        return m_view.alias != NULL;
+    }
+
+    /// @brief Returns the probability of selecting the token at the given index.
+    double probability(std::size_t index) const
+    {
+        if (!this->weighted()) {
+            return 1. / static_cast<double>(this->size());
+        }
+        if (m_view.total == 0) {
+            return index ? 0. : 1.;
+        }
+        return static_cast<double>(m_view.weights[index]) / static_cast<double>(m_view.total);
+    }
+
+    /// @brief Selects a token, with a single draw.
+    /// @param seed the seed used for random number generation.
+    /// @return the index of the selected token.
+    std::size_t select(uint64_t &seed) const
+    {
+        if (!this->weighted()) {
+            return detail::get_rand<std::size_t>(seed, 0UL, this->size());
+        }
+        return detail::sample_alias(m_view.alias, m_view.size, detail::get_rand(seed));
+    }
+
+private:
+    /// @brief Appends a token, without updating the alias table.
+    void append(const char *token, std::size_t length, uint32_t weight)
+    {
+        m_offsets.push_back(static_cast<uint32_t>(m_pool.size()));
+        m_lengths.push_back(static_cast<uint32_t>(length));
+        m_weights.push_back(weight);
+        m_pool.insert(m_pool.end(), token, token + length);
+        m_pool.push_back(0);
+    }
+
+    /// @brief Recomputes the total weight and the alias table.
+    void update()
+    {
+        bool uniform = true;
+        m_view.total = 0;
+        for (std::size_t i = 0; i < m_weights.size(); ++i) {
+            uniform = uniform && (m_weights[i] == m_weights[0]) && (m_weights[i] != 0);
+            m_view.total += m_weights[i];
+        }
+        m_alias.clear();
+        if (!uniform) {
+            std::vector<double> weights(m_weights.begin(), m_weights.end());
+            detail::build_alias(m_alias, weights);
+        }
+        this->bind();
+    }
+
+    /// @brief Returns true if the table owns its arrays.
+    bool owned() const
+    {
+        return m_view.pool == (m_pool.empty() ? NULL : &m_pool[0]);
+    }
+
+    /// @brief Copies the arrays of a view, so that they can be changed.
+    void own()
+    {
+        if (this->owned()) {
+            return;
+        }
+        std::size_t size = m_view.size;
+        m_pool.assign(m_view.pool, m_view.pool + m_view.pool_size);
+        m_offsets.assign(m_view.offsets, m_view.offsets + size);
+        m_lengths.assign(m_view.lengths, m_view.lengths + size);
+        m_weights.assign(m_view.weights, m_view.weights + size);
+        m_alias.clear();
+        if (m_view.alias) {
+            m_alias.assign(m_view.alias, m_view.alias + size);
+        }
+        this->bind();
+    }
+
+    /// @brief Points the view to the arrays owned by the table.
+    void bind()
+    {
+        m_view.pool      = m_pool.empty() ? NULL : &m_pool[0];
+        m_view.offsets   = m_offsets.empty() ? NULL : &m_offsets[0];
+        m_view.lengths   = m_lengths.empty() ? NULL : &m_lengths[0];
+        m_view.weights   = m_weights.empty() ? NULL : &m_weights[0];
+        m_view.alias     = m_alias.empty() ? NULL : &m_alias[0];
+        m_view.size      = m_offsets.size();
+        m_view.pool_size = m_pool.size();
+    }
+
+    /// The tokens, each one followed by a zero.
+    std::vector<char> m_pool;
+    /// Where each token starts inside the pool.
+    std::vector<uint32_t> m_offsets;
+    /// The length of each token.
+    std::vector<uint32_t> m_lengths;
+    /// The weight of each token.
+    std::vector<uint32_t> m_weights;
+    /// The alias table, empty if all the tokens weigh the same.
+    std::vector<alias_entry> m_alias;
+    /// The arrays in use, either the ones above or external ones.
+    layout m_view;
+};
+
+/// @brief Contains support functions.
+namespace detail
+{
+
+/// @brief Returns the built-in table with the given key.
+/// @param key the key of the table.
+/// @return the table, or NULL if there is no table with that key.
+inline const token_table *get_table(int key)
+{
+    static const char keys[]          = "svVcBCimMDd";
+    static const token_table tables[] = {
+        token_table('s'), token_table('v'), token_table('V'), token_table('c'),
+        token_table('B'), token_table('C'), token_table('i'), token_table('m'),
+        token_table('M'), token_table('D'), token_table('d')
+    };
+    for (std::size_t i = 0; keys[i]; ++i) {
+        if (keys[i] == key) {
+            return &tables[i];
+        }
+    }
+    return NULL;
+}
+
+} // namespace detail
+
+} // namespace namegen
@@ -0,0 +1,125 @@
+/// @file binary.cpp
+/// @brief Checks that binary dictionaries load back what was saved, and that
+/// corrupted images are rejected.
+
+#include "namegen/binary.hpp"
+#include "namegen/engine.hpp"
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+/// @brief Checks that two tables hold the same tokens and weights.
+static bool same_table(const namegen::token_table *a, const namegen::token_table *b)
+{
+    if (!a || !b || (a->size() != b->size()) || (a->weighted() != b->weighted())) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a->size(); ++i) {
+        if ((std::string(a->token(i), a->length(i)) != std::string(b->token(i), b->length(i))) ||
+            (a->weight(i) != b->weight(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Loads an image copied in aligned memory, which outlives the
+/// dictionary through retain().
+static bool load_image(namegen::dictionary &tables, const std::string &image)
+{
+    std::shared_ptr<std::vector<uint64_t> > copy = std::make_shared<std::vector<uint64_t> >((image.size() + 7) / 8);
+    std::memcpy(&(*copy)[0], image.data(), image.size());
+    if (!namegen::load(tables, &(*copy)[0], image.size())) {
+        return false;
+    }
+    tables.retain(copy);
+    return true;
+}
+
+/// @brief Returns where the arrays of the table of a key are stored.
+static namegen::detail::file_table find_table(const std::string &image, unsigned char key)
+{
+    namegen::detail::file_header header;
+    namegen::detail::file_table entry;
+    std::memcpy(&header, image.data(), sizeof(header));
+    std::memcpy(&entry, image.data() + header.table_offset + header.keys[key] * sizeof(entry), sizeof(entry));
+    return entry;
+}
+
+int main(int, char *[])
+{
+    namegen::dictionary saved;
+    std::vector<std::string> tokens;
+    tokens.push_back("ka");
+    tokens.push_back("zul");
+    tokens.push_back("");
+    std::vector<uint32_t> weights;
+    weights.push_back(3);
+    weights.push_back(1);
+    weights.push_back(2);
+    CHECK(saved.insert('x', namegen::token_table(tokens, weights)));
+    CHECK(saved.insert("uniform", namegen::token_table(tokens)));
+    CHECK(saved.insert('s', namegen::token_table(std::vector<std::string>(1, "ae"))));
+
+    // The file gives back the same tables, and the same names.
+    std::ostringstream stream;
+    stream << "namegen-test-" << ::getpid() << ".dic";
+    std::string path = stream.str();
+    CHECK(namegen::save(saved, path));
+    {
+        namegen::dictionary loaded;
+        CHECK(namegen::load(loaded, path));
+        std::remove(path.c_str());
+        CHECK(loaded.keys() == saved.keys());
+        CHECK(loaded.names() == saved.names());
+        CHECK(same_table(loaded.find('x'), saved.find('x')));
+        CHECK(same_table(loaded.find('s'), saved.find('s')));
+        CHECK(same_table(loaded.find("uniform"), saved.find("uniform")));
+        namegen::pattern from_file, from_memory;
+        CHECK(namegen::compile(from_file, "x$uniform<s|x>", loaded) == namegen::SUCCESS);
+        CHECK(namegen::compile(from_memory, "x$uniform<s|x>", saved) == namegen::SUCCESS);
+        for (uint64_t i = 0; i < 64; ++i) {
+            uint64_t file_seed = i + 1, memory_seed = i + 1;
+            std::string file_name, memory_name;
+            CHECK(namegen::generate(file_name, from_file, file_seed) == namegen::SUCCESS);
+            CHECK(namegen::generate(memory_name, from_memory, memory_seed) == namegen::SUCCESS);
+            CHECK(file_name == memory_name);
+        }
+    }
+
+    std::string image;
+    namegen::detail::serialize(image, saved);
+    namegen::dictionary tables;
+    CHECK(load_image(tables, image));
+    const namegen::detail::file_table entry = find_table(image, 'x');
+    CHECK(entry.alias != 0);
+
+    // A token that ends past the pool is rejected.
+    std::string corrupted = image;
+    uint32_t offset       = static_cast<uint32_t>(entry.pool_size);
+    std::memcpy(&corrupted[entry.offsets + sizeof(uint32_t)], &offset, sizeof(offset));
+    CHECK(!load_image(tables, corrupted));
+    // So is a length that overflows the pool.
+    corrupted       = image;
+    uint32_t length = 0xffffffffU;
+    std::memcpy(&corrupted[entry.lengths], &length, sizeof(length));
+    CHECK(!load_image(tables, corrupted));
+    // So is a token without its terminator.
+    corrupted = image;
+    length    = 1;
+    std::memcpy(&corrupted[entry.lengths], &length, sizeof(length));
+    CHECK(!load_image(tables, corrupted));
+    // So is an alias outside the table.
+    corrupted      = image;
+    uint32_t alias = static_cast<uint32_t>(entry.size);
+    std::memcpy(&corrupted[entry.alias + offsetof(namegen::alias_entry, alias)], &alias, sizeof(alias));
+    CHECK(!load_image(tables, corrupted));
+    // So is a truncated image.
+    CHECK(!load_image(tables, image.substr(0, image.size() - 8)));
+
+    // The rejected images left the dictionary as it was.
+    CHECK(same_table(tables.find('x'), saved.find('x')));
+    return TEST_RESULT();
+}
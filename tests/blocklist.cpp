@@ -0,0 +1,49 @@
+/// @file blocklist.cpp
+/// @brief Checks the blocklist, and the generation of names without banned
+/// words.
+
+#include "namegen/blocklist.hpp"
+
+#include "test.hpp"
+
+int main(int, char *[])
+{
+    std::vector<std::string> words;
+    words.push_back("bad");
+    words.push_back("");
+    words.push_back("Ugly");
+    namegen::blocklist folded(words), exact(words, false);
+    CHECK(folded.contains("Badmor"));
+    CHECK(folded.contains("morUGLY"));
+    CHECK(!folded.contains("Bd"));
+    CHECK(!folded.contains(""));
+    CHECK(exact.contains("morbad"));
+    CHECK(!exact.contains("Badmor"));
+    CHECK(!exact.contains("ugly"));
+    // Only ASCII letters are folded, whatever the locale: "\xc9" is 'É' in
+    // Latin-1, and '\xe9' is 'é'.
+    std::vector<std::string> accented(1, "\xe9t\xe9");
+    namegen::blocklist latin(accented);
+    CHECK(latin.contains("\xe9T\xe9"));
+    CHECK(!latin.contains("\xc9t\xc9"));
+    // A streaming check stops at the first banned word.
+    uint32_t state = folded.start();
+    const char *name = "xbAdx";
+    for (const char *c = name; *c; ++c) {
+        state = folded.step(state, static_cast<unsigned char>(*c));
+    }
+    CHECK(folded.blocked(state));
+
+    // Retrying gives a name without banned words.
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "(bad|good)") == namegen::SUCCESS);
+    std::string result;
+    uint64_t seed = 7;
+    for (int i = 0; i < 64; ++i) {
+        CHECK(namegen::generate(result, compiled, folded, seed, 64) == namegen::SUCCESS);
+        CHECK(result == "good");
+    }
+    CHECK(namegen::compile(compiled, "(bad)") == namegen::SUCCESS);
+    CHECK(namegen::generate(result, compiled, folded, seed, 8) == namegen::UNSATISFIABLE);
+    return TEST_RESULT();
+}
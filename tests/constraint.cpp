@@ -0,0 +1,62 @@
+/// @file constraint.cpp
+/// @brief Checks that the names drawn under a prefix or a suffix satisfy it,
+/// and are names of the pattern.
+
+#include "namegen/constraint.hpp"
+#include "namegen/match.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+/// @brief Returns true if the name starts with the prefix and ends with the
+/// suffix.
+static bool surrounds(const std::string &name, const std::string &prefix, const std::string &suffix)
+{
+    return (name.size() >= prefix.size()) && (name.size() >= suffix.size()) &&
+           (name.compare(0, prefix.size(), prefix) == 0) &&
+           (name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+int main(int, char *[])
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "<ka|ko|z>s<an|on|>") == namegen::SUCCESS);
+    namegen::automaton spelled(compiled);
+    namegen::matcher names(compiled);
+
+    const char *prefixes[] = { "", "ka", "kor", "z" };
+    const char *suffixes[] = { "", "n", "on" };
+    for (std::size_t p = 0; p < 4; ++p) {
+        for (std::size_t s = 0; s < 3; ++s) {
+            namegen::dfa constraint = namegen::intersect(namegen::prefix_constraint(prefixes[p]), namegen::suffix_constraint(suffixes[s]));
+            namegen::constrained_sampler sampler(spelled, constraint);
+            CHECK(sampler.probability() > 0.);
+            CHECK(sampler.probability() <= 1.000001);
+            for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+                uint64_t seed = TEST_SEED(i);
+                std::string name;
+                CHECK(namegen::generate(name, sampler, seed) == namegen::SUCCESS);
+                CHECK(surrounds(name, prefixes[p], suffixes[s]));
+                CHECK(names.matches(name));
+            }
+        }
+    }
+
+    // Without a constraint, every name is accepted.
+    namegen::dfa anything = namegen::prefix_constraint("");
+    namegen::constrained_sampler all(spelled, anything);
+    CHECK((all.probability() > 0.999999) && (all.probability() < 1.000001));
+    // A third of the names start with "ka".
+    namegen::dfa prefix = namegen::prefix_constraint("ka");
+    namegen::constrained_sampler third(spelled, prefix);
+    CHECK((third.probability() > 0.333333) && (third.probability() < 0.333334));
+
+    // No name starts with "q".
+    namegen::dfa never = namegen::prefix_constraint("q");
+    namegen::constrained_sampler none(spelled, never);
+    CHECK(none.probability() == 0.);
+    std::string name;
+    uint64_t seed = 1;
+    CHECK(namegen::generate(name, none, seed) == namegen::UNSATISFIABLE);
+    return TEST_RESULT();
+}
@@ -0,0 +1,78 @@
+/// @file encoding.cpp
+/// @brief Checks that encoded names decode to the names that were generated.
+
+#include "namegen/encoding.hpp"
+#include "namegen/engine.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+/// @brief Checks the round trip of the names of a pattern.
+static void check_pattern(const std::string &source)
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, source) == namegen::SUCCESS);
+    CHECK(namegen::set_engine(compiled, namegen::pattern::ENGINE_TREE) == namegen::SUCCESS);
+    for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+        uint64_t seed = TEST_SEED(i), tree_seed = TEST_SEED(i);
+        std::string name, tree_name, decoded;
+        namegen::encoded_name encoded;
+        CHECK(namegen::generate(name, encoded, compiled, seed) == namegen::SUCCESS);
+        CHECK(namegen::decode(decoded, compiled, encoded) == namegen::SUCCESS);
+        CHECK(decoded == name);
+        // The encoder walks the tree, drawing like it.
+        CHECK(namegen::generate(tree_name, compiled, tree_seed) == namegen::SUCCESS);
+        CHECK(tree_name == name);
+        CHECK(tree_seed == seed);
+    }
+}
+
+int main(int, char *[])
+{
+#define CHECK_PATTERN(name, source) check_pattern(source);
+    TEST_PATTERNS(CHECK_PATTERN)
+#undef CHECK_PATTERN
+
+    namegen::pattern compiled;
+    namegen::encoded_name encoded;
+    std::string name;
+    uint64_t seed = 1;
+    // Sixteen choices do not fit.
+    CHECK(namegen::compile(compiled, "ssssssssssssssss") == namegen::SUCCESS);
+    CHECK(namegen::generate(name, encoded, compiled, seed) == namegen::TOO_LONG);
+    CHECK(name.empty() && encoded.empty());
+    // Choices out of range, or missing, do not belong to the pattern.
+    CHECK(namegen::compile(compiled, "(a|b)") == namegen::SUCCESS);
+    encoded.push_back(2);
+    CHECK(namegen::decode(name, compiled, encoded) == namegen::INVALID);
+    encoded.clear();
+    CHECK(namegen::decode(name, compiled, encoded) == namegen::INVALID);
+    encoded.push_back(1);
+    CHECK((namegen::decode(name, compiled, encoded) == namegen::SUCCESS) && (name == "b"));
+    encoded.push_back(0);
+    CHECK(namegen::decode(name, compiled, encoded) == namegen::INVALID);
+    // Neither does an index too large for a size_t.
+    encoded.clear();
+    while (encoded.push_back(0x80)) {
+    }
+    CHECK(namegen::decode(name, compiled, encoded) == namegen::INVALID);
+    encoded.clear();
+    for (std::size_t i = 0; i < 10; ++i) {
+        encoded.push_back(0x80);
+    }
+    encoded.push_back(0);
+    CHECK(namegen::decode(name, compiled, encoded) == namegen::INVALID);
+
+    // The encoder walks the tree, even when the pattern uses the table.
+    CHECK(namegen::compile(compiled, "<v|V>(dim)") == namegen::SUCCESS);
+    namegen::pattern table = compiled;
+    CHECK(namegen::set_engine(table, namegen::pattern::ENGINE_TABLE) == namegen::SUCCESS);
+    for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+        uint64_t table_seed = TEST_SEED(i), tree_seed = TEST_SEED(i);
+        std::string table_name, tree_name;
+        CHECK(namegen::generate(table_name, encoded, table, table_seed) == namegen::SUCCESS);
+        CHECK(namegen::generate(tree_name, compiled, tree_seed) == namegen::SUCCESS);
+        CHECK(table_name == tree_name);
+    }
+    return TEST_RESULT();
+}
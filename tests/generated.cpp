@@ -0,0 +1,27 @@
+/// @file generated.cpp
+/// @brief Checks that the functions written by namegen-patternc draw the same
+/// numbers as the single-pass generator, and give the same names.
+
+#include "test_patterns.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+#include <string>
+
+int main(int, char *[])
+{
+#define CHECK_PATTERN(name, source)                                                    \
+    for (std::size_t i = 0; i < TEST_SEEDS; ++i) {                                     \
+        uint64_t serial_seed = TEST_SEED(i), generated_seed = TEST_SEED(i);            \
+        std::string serial_name;                                                       \
+        char generated_name[patterns::name##_max_length + 1];                          \
+        CHECK(namegen::generate(serial_name, source, serial_seed) == namegen::SUCCESS); \
+        std::size_t length = patterns::name(generated_name, generated_seed);           \
+        CHECK(std::string(generated_name, length) == serial_name.c_str());             \
+        CHECK(generated_seed == serial_seed);                                          \
+    }
+    TEST_PATTERNS(CHECK_PATTERN)
+#undef CHECK_PATTERN
+    return TEST_RESULT();
+}
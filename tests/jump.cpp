@@ -0,0 +1,46 @@
+/// @file jump.cpp
+/// @brief Checks that jumping ahead leaves the seed as drawing the numbers one
+/// at a time does.
+
+#include "namegen/jump.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+int main(int, char *[])
+{
+    const uint64_t draws[] = { 0, 1, 2, 3, 63, 64, 65, 1000, 12345 };
+    for (std::size_t i = 0; i < 64; ++i) {
+        for (std::size_t d = 0; d < sizeof(draws) / sizeof(draws[0]); ++d) {
+            uint64_t drawn = TEST_SEED(i), jumped = TEST_SEED(i);
+            for (uint64_t n = 0; n < draws[d]; ++n) {
+                namegen::detail::get_rand(drawn);
+            }
+            namegen::jump(jumped, draws[d]);
+            CHECK(jumped == drawn);
+        }
+    }
+
+    // Jumps add up, and the low bits repeat after a period.
+    uint64_t seed = TEST_SEED(1), once = seed, twice = seed;
+    namegen::jump(once, 0x123456789ULL + 0x9876543ULL);
+    namegen::jump(twice, 0x123456789ULL);
+    namegen::jump(twice, 0x9876543ULL);
+    CHECK(once == twice);
+    uint64_t period = seed;
+    namegen::jump(period, NAME_RAND_PERIOD);
+    CHECK((period & 0xffffffffULL) == (seed & 0xffffffffULL));
+
+    // Substreams start a fixed stride apart.
+    std::vector<uint64_t> seeds = namegen::split(seed, 4);
+    CHECK(seeds.size() == 4);
+    CHECK((seeds.size() > 0) && (seeds[0] == seed));
+    for (std::size_t i = 1; i < seeds.size(); ++i) {
+        uint64_t next = seeds[i - 1];
+        namegen::jump(next, NAME_RAND_PERIOD / 4);
+        CHECK(seeds[i] == next);
+        CHECK((seeds[i] & 0xffffffffULL) != (seeds[i - 1] & 0xffffffffULL));
+    }
+    CHECK(namegen::split(seed, 0).empty());
+    return TEST_RESULT();
+}
@@ -0,0 +1,58 @@
+/// @file length.cpp
+/// @brief Checks that the names drawn by length fall inside the range, and
+/// are names of the pattern.
+
+#include "namegen/length.hpp"
+#include "namegen/match.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+int main(int, char *[])
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "!<s|ss|sss>(-<v|>)") == namegen::SUCCESS);
+    namegen::matcher names(compiled);
+    namegen::length_sampler uniform(compiled);
+    namegen::length_sampler weighted(compiled, namegen::PATTERN_DISTRIBUTION);
+    CHECK(uniform.max_length() == weighted.max_length());
+
+    // The probabilities of the lengths sum to one.
+    double total = 0;
+    for (std::size_t l = 0; l <= weighted.max_length(); ++l) {
+        total += weighted.count(l);
+    }
+    CHECK((total > 0.999999) && (total < 1.000001));
+    CHECK(uniform.count(weighted.max_length() + 1) == 0.);
+
+    // The shortest names, the rarest ones.
+    std::size_t shortest = 0;
+    while ((shortest < uniform.max_length()) && !(uniform.count(shortest) > 0.)) {
+        ++shortest;
+    }
+    CHECK(weighted.count(shortest) > 0.);
+
+    const namegen::length_sampler *samplers[] = { &uniform, &weighted };
+    for (std::size_t s = 0; s < 2; ++s) {
+        for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+            uint64_t seed = TEST_SEED(i);
+            std::string name;
+            CHECK(namegen::generate(name, *samplers[s], 7, 8, seed) == namegen::SUCCESS);
+            CHECK((name.size() >= 7) && (name.size() <= 8));
+            CHECK(names.matches(name));
+            CHECK(namegen::generate(name, *samplers[s], 0, shortest, seed) == namegen::SUCCESS);
+            CHECK(name.size() == shortest);
+            CHECK(names.matches(name));
+        }
+    }
+
+    // Ranges without names, and patterns never compiled.
+    std::string name;
+    uint64_t seed = 1;
+    CHECK(namegen::generate(name, uniform, uniform.max_length() + 1, uniform.max_length() + 8, seed) == namegen::UNSATISFIABLE);
+    CHECK(namegen::generate(name, uniform, 0, shortest - 1, seed) == namegen::UNSATISFIABLE);
+    namegen::pattern empty;
+    namegen::length_sampler none(empty);
+    CHECK(namegen::generate(name, none, 0, 8, seed) == namegen::INVALID);
+    return TEST_RESULT();
+}
@@ -0,0 +1,41 @@
+/// @file match.cpp
+/// @brief Checks the matching of names against patterns.
+
+#include "namegen/match.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+/// @brief Checks that a pattern matches the names it generates.
+static void check_pattern(const std::string &source)
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, source) == namegen::SUCCESS);
+    namegen::matcher names(compiled);
+    for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+        uint64_t seed = TEST_SEED(i);
+        std::string name;
+        CHECK(namegen::generate(name, compiled, seed) == namegen::SUCCESS);
+        CHECK(names.matches(name));
+    }
+}
+
+int main(int, char *[])
+{
+#define CHECK_PATTERN(name, source) check_pattern(source);
+    TEST_PATTERNS(CHECK_PATTERN)
+#undef CHECK_PATTERN
+
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "!(foo|bar)<(s)|>") == namegen::SUCCESS);
+    CHECK(namegen::matches(compiled, "Foo"));
+    CHECK(namegen::matches(compiled, "Bars"));
+    CHECK(!namegen::matches(compiled, "foo"));
+    CHECK(!namegen::matches(compiled, "Foos "));
+    CHECK(!namegen::matches(namegen::pattern(), "Foo"));
+    // Names need not be terminated by a zero.
+    CHECK(namegen::matches(compiled, "Foosball", 4));
+    CHECK(!namegen::matches(compiled, "Foosball", 5));
+    CHECK(namegen::matcher(compiled).matches("Bar", 3));
+    return TEST_RESULT();
+}
@@ -0,0 +1,79 @@
+/// @file name_pool.cpp
+/// @brief Checks the names of a name_pool, with and without the background
+/// thread.
+
+#include "namegen/match.hpp"
+#include "namegen/name_pool.hpp"
+
+#include "test.hpp"
+
+int main(int, char *[])
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "!BVC<s|>") == namegen::SUCCESS);
+    namegen::matcher names(compiled);
+
+    // Names from the rings, and from the callers once they run dry.
+    {
+        namegen::name_pool pool(64, 31, 16, 4);
+        std::size_t id = pool.add(compiled, 1);
+        pool.start();
+        namegen::name_pool::cache local;
+        std::string name;
+        for (int i = 0; i < 1000; ++i) {
+            CHECK(pool.pop(name, id, local) == namegen::SUCCESS);
+            CHECK(names.matches(name));
+        }
+        pool.stop();
+        namegen::name_pool::statistics stats = pool.stats();
+        // The names taken from the rings include the ones left in the cache.
+        CHECK(stats.popped + stats.starved >= 1000);
+        CHECK(stats.popped + stats.starved < 1000 + 4);
+        CHECK(stats.dropped == 0);
+    }
+
+    // Names longer than the rings are dropped, without blocking start().
+    {
+        namegen::pattern longer;
+        CHECK(namegen::compile(longer, "ssss") == namegen::SUCCESS);
+        namegen::name_pool pool(64, 3, 16, 4);
+        std::size_t id = pool.add(longer, 1);
+        pool.start();
+        namegen::name_pool::cache local;
+        std::string name;
+        CHECK(pool.pop(name, id, local) == namegen::SUCCESS);
+        CHECK(name.size() > 3);
+        pool.stop();
+        CHECK(pool.size(id) == 0);
+        CHECK(pool.stats().dropped > 0);
+        CHECK(pool.stats().starved == 1);
+    }
+
+    // An empty batch is taken as a batch of one.
+    {
+        namegen::name_pool pool(64, 31, 0, 4);
+        std::size_t id = pool.add(compiled, 1);
+        pool.start();
+        pool.stop();
+        CHECK(pool.size(id) > 0);
+    }
+
+    // Caches without a seed, and patterns, get streams of their own.
+    {
+        namegen::name_pool pool(64, 31, 16, 4);
+        std::size_t first = pool.add(compiled, 1), second = pool.add(compiled, 2);
+        namegen::name_pool::cache one, two;
+        std::string a, b, c;
+        int same_cache = 0, same_pattern = 0;
+        for (int i = 0; i < 64; ++i) {
+            CHECK(pool.pop(a, first, one) == namegen::SUCCESS);
+            CHECK(pool.pop(b, first, two) == namegen::SUCCESS);
+            CHECK(pool.pop(c, second, one) == namegen::SUCCESS);
+            same_cache += a == b;
+            same_pattern += a == c;
+        }
+        CHECK(same_cache < 16);
+        CHECK(same_pattern < 16);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,47 @@
+/// @file parallel.cpp
+/// @brief Checks that the parallel generation gives the names, and leaves
+/// the seed, of a serial loop.
+
+#include "namegen/parallel.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+/// @brief Compares the parallel generation of a pattern with a serial loop.
+static void check_pattern(const std::string &source)
+{
+    const std::size_t counts[]  = { 1, 7, 1000 };
+    const std::size_t threads[] = { 1, 3, 8 };
+    for (std::size_t c = 0; c < 3; ++c) {
+        for (std::size_t t = 0; t < 3; ++t) {
+            uint64_t serial_seed = TEST_SEED(c * 3 + t), parallel_seed = serial_seed;
+            std::vector<std::string> names;
+            CHECK(namegen::generate_parallel(names, source, counts[c], parallel_seed, threads[t]) == namegen::SUCCESS);
+            CHECK(names.size() == counts[c]);
+            for (std::size_t i = 0; i < names.size(); ++i) {
+                std::string name;
+                CHECK(namegen::generate(name, source, serial_seed) == namegen::SUCCESS);
+                CHECK(names[i] == name.c_str());
+            }
+            CHECK(parallel_seed == serial_seed);
+        }
+    }
+}
+
+int main(int, char *[])
+{
+#define CHECK_PATTERN(name, source) check_pattern(source);
+    TEST_PATTERNS(CHECK_PATTERN)
+#undef CHECK_PATTERN
+
+    // Errors leave the seed untouched, and no names.
+    std::vector<std::string> names(4);
+    uint64_t seed = 1;
+    CHECK(namegen::generate_parallel(names, "<s", 16, seed, 2) != namegen::SUCCESS);
+    CHECK(names.empty());
+    CHECK(seed == 1);
+    CHECK(namegen::generate_parallel(names, "s", 0, seed, 2) == namegen::SUCCESS);
+    CHECK(names.empty());
+    CHECK(seed == 1);
+    return TEST_RESULT();
+}
@@ -0,0 +1,92 @@
+/// @file parity.cpp
+/// @brief Checks that the engines of a compiled pattern draw the same numbers
+/// as the single-pass generator, and give the same names.
+
+#include "namegen/engine.hpp"
+#include "namegen/match.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+/// @brief Checks a pattern with the tree and the bytecode, against the
+/// single-pass generator when the pattern has no weights.
+static void check_pattern(const std::string &source)
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, source) == namegen::SUCCESS);
+    // The table draws a different stream, and is never chosen implicitly.
+    CHECK(compiled.engine != namegen::pattern::ENGINE_TABLE);
+    namegen::pattern tree = compiled, bytecode = compiled;
+    CHECK(namegen::set_engine(tree, namegen::pattern::ENGINE_TREE) == namegen::SUCCESS);
+    CHECK(namegen::set_engine(bytecode, namegen::pattern::ENGINE_BYTECODE) == namegen::SUCCESS);
+    // Weighted groups draw from an alias table once compiled.
+    bool weighted = false;
+    for (std::size_t i = 0; i < compiled.groups.size(); ++i) {
+        weighted = weighted || compiled.groups[i].weighted;
+    }
+    for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+        uint64_t serial_seed = TEST_SEED(i), tree_seed = TEST_SEED(i), bytecode_seed = TEST_SEED(i);
+        uint64_t chosen_seed = TEST_SEED(i);
+        std::string serial_name, tree_name, bytecode_name, chosen_name;
+        CHECK(namegen::generate(serial_name, source, serial_seed) == namegen::SUCCESS);
+        CHECK(namegen::generate(chosen_name, compiled, chosen_seed) == namegen::SUCCESS);
+        CHECK(namegen::generate(tree_name, tree, tree_seed) == namegen::SUCCESS);
+        CHECK(namegen::generate(bytecode_name, bytecode, bytecode_seed) == namegen::SUCCESS);
+        CHECK(tree_name == bytecode_name);
+        CHECK(tree_seed == bytecode_seed);
+        CHECK(tree_name == chosen_name);
+        CHECK(tree_seed == chosen_seed);
+        if (!weighted) {
+            CHECK(tree_name == serial_name.c_str());
+            CHECK(tree_seed == serial_seed);
+        }
+    }
+}
+
+int main(int, char *[])
+{
+#define CHECK_PATTERN(name, source) check_pattern(source);
+    TEST_PATTERNS(CHECK_PATTERN)
+#undef CHECK_PATTERN
+
+    // Literal groups have no weights, and escape the colon of a token group.
+    // The single-pass generator ends the name with a zero.
+    std::string name;
+    uint64_t seed = 42;
+    CHECK(namegen::generate(name, "(12:30)", seed) == namegen::SUCCESS);
+    CHECK(std::string(name.c_str()) == "12:30");
+    CHECK(namegen::generate(name, "(ratio 3:1)", seed) == namegen::SUCCESS);
+    CHECK(std::string(name.c_str()) == "ratio 3:1");
+    CHECK(namegen::generate(name, "<a|b>(:3)", seed) == namegen::SUCCESS);
+    CHECK((std::string(name.c_str()) == "a:3") || (std::string(name.c_str()) == "b:3"));
+    CHECK(namegen::generate(name, "<a|b>:3", seed) == namegen::SUCCESS);
+    CHECK((std::string(name.c_str()) == "a") || (std::string(name.c_str()) == "b"));
+
+    // Names without a table keep their dollar sign literal.
+    namegen::pattern compiled;
+    namegen::dictionary tables;
+    CHECK(tables.insert("elf", namegen::token_table(std::vector<std::string>(1, "ae"))));
+    CHECK(namegen::compile(compiled, "$elf$run$", tables) == namegen::SUCCESS);
+    CHECK(namegen::generate(name, compiled, seed) == namegen::SUCCESS);
+    CHECK(name == "ae$run$");
+
+    // compile() does not build the table, and calibrate() builds it to time
+    // it, without choosing it.
+    CHECK(namegen::compile(compiled, "<v|V>(dim)") == namegen::SUCCESS);
+    CHECK(compiled.outputs.lengths.empty());
+    CHECK(compiled.cost.table == std::numeric_limits<double>::infinity());
+    CHECK(namegen::calibrate(compiled, 64) == namegen::SUCCESS);
+    CHECK(compiled.engine != namegen::pattern::ENGINE_TABLE);
+    CHECK(compiled.cost.table < std::numeric_limits<double>::infinity());
+    // The table is opt-in, and built on demand for the patterns with few
+    // derivations.
+    CHECK(namegen::compile(compiled, "<v|V>(dim)") == namegen::SUCCESS);
+    CHECK(namegen::set_engine(compiled, namegen::pattern::ENGINE_TABLE) == namegen::SUCCESS);
+    CHECK(!compiled.outputs.lengths.empty());
+    CHECK(compiled.cost.table < std::numeric_limits<double>::infinity());
+    CHECK(namegen::generate(name, compiled, seed) == namegen::SUCCESS);
+    CHECK(namegen::matches(compiled, name));
+    CHECK(namegen::compile(compiled, "ssssssss") == namegen::SUCCESS);
+    CHECK(namegen::set_engine(compiled, namegen::pattern::ENGINE_TABLE) == namegen::INVALID);
+    return TEST_RESULT();
+}
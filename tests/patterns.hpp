@@ -0,0 +1,37 @@
+/// @file patterns.hpp
+/// @brief Patterns shared by the seed-parity tests.
+/// @details
+/// The same patterns, under the same names, are listed in patterns.txt, which
+/// namegen-patternc compiles for the test of the generated functions.
+
+#pragma once
+
+/// Applies a macro to the name and the source of every pattern.
+#define TEST_PATTERNS(X)                    \
+    X(syllable, "s")                        \
+    X(elf, "!BVC(ith)")                     \
+    X(orc, "!<B|C>v(g|k)<s|>")              \
+    X(optional, "<c|v|>")                   \
+    X(literals, "(foo|bar)")                \
+    X(capital, "!(foo)")                    \
+    X(inner, "v!s")                         \
+    X(nested, "<<s|v>|(x|y)|>!M")           \
+    X(mixed, "!ssV'!i")                     \
+    X(skipped, "!(a|b|c)!D<d|>")            \
+    X(suffix, "s(dim)")                     \
+    X(empty, "<>")                          \
+    X(materialized, "<v|V>(dim)")           \
+    X(deep, "!<<B|C>|!(zz)>v")              \
+    X(dwarf, "!<B|C>V<s|>'!<c:3|s:1>")      \
+    X(weighted, "<s:5|v:1|>!<(ar|or):2|C>") \
+    X(clock, "(12:30|1:5)")                 \
+    X(ratio, "s(ratio 3:1)")                \
+    X(escaped, "<a|b>(:3)")                 \
+    X(dollar, "s$vs")                       \
+    X(price, "!s(-)$d")
+
+/// Number of seeds each pattern is checked with.
+#define TEST_SEEDS 512
+
+/// Returns the i-th seed of a test.
+#define TEST_SEED(i) (static_cast<uint64_t>(i) * 0x9e3779b97f4a7c15ULL + 1)
@@ -0,0 +1,61 @@
+/// @file probability.cpp
+/// @brief Checks the probabilities of names, summed over their derivations,
+/// and the order of the most probable ones.
+
+#include "namegen/probability.hpp"
+
+#include "test.hpp"
+
+#include <set>
+
+/// @brief Returns true if the values are equal, up to rounding errors.
+static bool near(double a, double b)
+{
+    return std::fabs(a - b) < 1e-9;
+}
+
+int main(int, char *[])
+{
+    // "ab" has two derivations, "a" and "abb" one each.
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "(a|ab)(b|)") == namegen::SUCCESS);
+    namegen::automaton spelled(compiled);
+    CHECK(near(namegen::log_probability(spelled, "ab"), std::log(0.5)));
+    CHECK(near(namegen::log_probability(spelled, "a"), std::log(0.25)));
+    CHECK(near(namegen::log_probability(compiled, "abb"), std::log(0.25)));
+    CHECK(namegen::log_probability(spelled, "b") == -std::numeric_limits<double>::infinity());
+    CHECK(namegen::log_probability(namegen::pattern(), "a") == -std::numeric_limits<double>::infinity());
+
+    // Asking for more names than the pattern has returns them all.
+    std::vector<namegen::scored_name> best;
+    namegen::top_k(best, spelled, 8);
+    CHECK(best.size() == 3);
+    CHECK((best.size() > 0) && (best[0].name == "ab"));
+    double total = 0;
+    for (std::size_t i = 0; i < best.size(); ++i) {
+        total += std::exp(best[i].log_probability);
+    }
+    CHECK(near(total, 1.));
+
+    // The names come from the most probable, with their own probability.
+    CHECK(namegen::compile(compiled, "!BV<s|C><v|>") == namegen::SUCCESS);
+    namegen::automaton names(compiled);
+    namegen::top_k(best, names, 200);
+    CHECK(best.size() == 200);
+    std::vector<std::string> candidates;
+    std::set<std::string> distinct;
+    for (std::size_t i = 0; i < best.size(); ++i) {
+        candidates.push_back(best[i].name);
+        distinct.insert(best[i].name);
+        CHECK((i == 0) || (best[i].log_probability <= best[i - 1].log_probability));
+    }
+    CHECK(distinct.size() == best.size());
+    std::vector<double> scores;
+    namegen::log_probability(scores, names, candidates);
+    for (std::size_t i = 0; i < best.size(); ++i) {
+        CHECK(near(scores[i], best[i].log_probability));
+    }
+    namegen::top_k(best, names, 0);
+    CHECK(best.empty());
+    return TEST_RESULT();
+}
@@ -0,0 +1,101 @@
+/// @file registry.cpp
+/// @brief Checks that catalogs recompile their patterns, and that readers of
+/// a registry keep their catalog while new ones are published.
+
+#include "namegen/registry.hpp"
+
+#include "test.hpp"
+
+#include <thread>
+
+/// @brief Returns a catalog whose pattern "x" emits the given token.
+static std::unique_ptr<namegen::catalog> make_catalog(const std::string &token)
+{
+    namegen::dictionary tables;
+    tables.insert('x', namegen::token_table(std::vector<std::string>(1, token)));
+    std::unique_ptr<namegen::catalog> result(new namegen::catalog(tables));
+    result->insert("x", "x");
+    return result;
+}
+
+/// @brief Returns the name the pattern "x" of a registry emits.
+static std::string generate_x(const namegen::registry &patterns)
+{
+    std::string name;
+    uint64_t seed = 1;
+    return (namegen::generate(name, patterns, "x", seed) == namegen::SUCCESS) ? name : "";
+}
+
+/// @brief Generates names until told to stop, counting the ones that come
+/// from no catalog.
+static void read_names(const namegen::registry *patterns, const std::atomic<bool> *done, std::atomic<int> *torn)
+{
+    while (!done->load()) {
+        std::string name = generate_x(*patterns);
+        if ((name != "a") && (name != "b")) {
+            torn->fetch_add(1);
+        }
+    }
+}
+
+int main(int, char *[])
+{
+    // Catalogs keep their patterns compiled against their own dictionary.
+    {
+        std::unique_ptr<namegen::catalog> original = make_catalog("a");
+        CHECK(original->insert("broken", "<s") != namegen::SUCCESS);
+        CHECK(original->find("broken") == NULL);
+        namegen::catalog copy(*original);
+        original.reset();
+        std::string name;
+        uint64_t seed = 1;
+        CHECK(copy.find("x") != NULL);
+        CHECK(namegen::generate(name, *copy.find("x"), seed) == namegen::SUCCESS);
+        CHECK(name == "a");
+        namegen::dictionary tables;
+        tables.insert('x', namegen::token_table(std::vector<std::string>(1, "b")));
+        CHECK(copy.assign(tables) == namegen::SUCCESS);
+        CHECK(namegen::generate(name, *copy.find("x"), seed) == namegen::SUCCESS);
+        CHECK(name == "b");
+        CHECK(copy.erase("x"));
+        CHECK(!copy.erase("x"));
+        CHECK(copy.find("x") == NULL);
+    }
+
+    // A reader keeps its catalog, which is reclaimed once it is gone.
+    namegen::registry patterns;
+    CHECK(generate_x(patterns).empty());
+    patterns.publish(make_catalog("a"));
+    CHECK(generate_x(patterns) == "a");
+    {
+        namegen::registry::reader pinned(patterns);
+        patterns.publish(make_catalog("b"));
+        CHECK(patterns.version() == 2);
+        CHECK(generate_x(patterns) == "b");
+        std::string name;
+        uint64_t seed = 1;
+        CHECK(namegen::generate(name, *pinned->find("x"), seed) == namegen::SUCCESS);
+        CHECK(name == "a");
+        CHECK(patterns.reclaim() == 1);
+    }
+    CHECK(patterns.reclaim() == 0);
+
+    // Readers only ever see whole catalogs, while they are replaced.
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.push_back(std::thread(read_names, &patterns, &done, &torn));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        patterns.publish(make_catalog((i % 2) ? "a" : "b"));
+    }
+    done.store(true);
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        readers[i].join();
+    }
+    CHECK(torn.load() == 0);
+    CHECK(patterns.version() == 1002);
+    CHECK(patterns.reclaim() == 0);
+    return TEST_RESULT();
+}
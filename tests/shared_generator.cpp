@@ -0,0 +1,102 @@
+/// @file shared_generator.cpp
+/// @brief Checks that threads sharing a generator get distinct counters, and
+/// that every name is generated again from its counter.
+
+#include "namegen/shared_generator.hpp"
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <thread>
+
+/// Number of threads sharing the generator.
+#define TEST_THREADS 4
+
+/// Number of names generated by each thread.
+#define TEST_NAMES 2000
+
+/// @brief The names a thread generated, with their counters.
+struct claimed_names {
+    std::vector<uint64_t> counters;
+    std::vector<std::string> names;
+};
+
+/// @brief Generates names with the shared generator.
+static void generate_names(namegen::shared_generator *generator, claimed_names *claimed)
+{
+    for (std::size_t i = 0; i < TEST_NAMES; ++i) {
+        std::string name;
+        uint64_t counter = 0;
+        if (namegen::generate(name, *generator, &counter) == namegen::SUCCESS) {
+            claimed->counters.push_back(counter);
+            claimed->names.push_back(name);
+        }
+    }
+}
+
+int main(int, char *[])
+{
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "!BVC<s|>") == namegen::SUCCESS);
+
+    // Every counter is handed out once, and gives back its name.
+    namegen::shared_generator generator(compiled, 42);
+    claimed_names claimed[TEST_THREADS];
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < TEST_THREADS; ++t) {
+        threads.push_back(std::thread(generate_names, &generator, &claimed[t]));
+    }
+    std::vector<uint64_t> counters;
+    for (std::size_t t = 0; t < TEST_THREADS; ++t) {
+        threads[t].join();
+        CHECK(claimed[t].counters.size() == TEST_NAMES);
+        counters.insert(counters.end(), claimed[t].counters.begin(), claimed[t].counters.end());
+        for (std::size_t i = 0; i < claimed[t].names.size(); ++i) {
+            std::string again;
+            CHECK(generator.at(again, claimed[t].counters[i]) == namegen::SUCCESS);
+            CHECK(again == claimed[t].names[i]);
+        }
+    }
+    std::sort(counters.begin(), counters.end());
+    for (std::size_t i = 0; i < counters.size(); ++i) {
+        CHECK(counters[i] == i);
+    }
+    CHECK(generator.counter() == TEST_THREADS * TEST_NAMES);
+
+    // Batches take consecutive counters.
+    namegen::name_arena arena;
+    uint64_t first = 0;
+    CHECK(namegen::generate(arena, generator, 16, &first) == namegen::SUCCESS);
+    CHECK(first == TEST_THREADS * TEST_NAMES);
+    CHECK(arena.size() == 16);
+    for (std::size_t i = 0; i < arena.size(); ++i) {
+        std::string again;
+        CHECK(generator.at(again, first + i) == namegen::SUCCESS);
+        CHECK(again == arena.name(i));
+    }
+
+    // The stream depends on the key, and starts at the given counter.
+    namegen::shared_generator other(compiled, 43, 100);
+    CHECK(other.key() == 43);
+    CHECK(other.counter() == 100);
+    std::size_t same = 0;
+    for (uint64_t i = 0; i < 64; ++i) {
+        std::string mine, theirs;
+        CHECK(generator.at(mine, i) == namegen::SUCCESS);
+        CHECK(other.at(theirs, i) == namegen::SUCCESS);
+        same += (mine == theirs) ? 1 : 0;
+    }
+    CHECK(same < 64);
+    std::string next, expected;
+    CHECK(namegen::generate(next, other) == namegen::SUCCESS);
+    CHECK(other.at(expected, 100) == namegen::SUCCESS);
+    CHECK(next == expected);
+
+    // The low bits of the seeds, the only ones drawn from, are never zero.
+    for (uint64_t key = 0; key < 16; ++key) {
+        for (uint64_t counter = 0; counter < 4096; ++counter) {
+            CHECK((namegen::detail::stream_seed(key, counter) & 0xffffffffULL) != 0);
+        }
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,54 @@
+/// @file shm_pool.cpp
+/// @brief Checks the names shared through POSIX shared memory.
+
+#include "namegen/match.hpp"
+#include "namegen/shm_pool.hpp"
+
+#include "test.hpp"
+
+#include <set>
+#include <sstream>
+
+int main(int, char *[])
+{
+    std::ostringstream stream;
+    stream << "/namegen-test-" << ::getpid();
+    std::string name = stream.str();
+
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "!BVC<s|>") == namegen::SUCCESS);
+    namegen::matcher names(compiled);
+    {
+        namegen::shm_producer producer(name, compiled, 1, 256, 31);
+        CHECK(producer.valid());
+        namegen::shm_consumer consumer(name);
+        CHECK(consumer.valid());
+        // The names are unique, across refills.
+        std::set<std::string> seen;
+        std::string taken;
+        for (int round = 0; round < 8; ++round) {
+            std::size_t pushed = producer.fill(64);
+            CHECK(pushed > 0);
+            CHECK(producer.status() == namegen::SUCCESS);
+            for (std::size_t i = 0; i < pushed; ++i) {
+                CHECK(consumer.pop(taken));
+                CHECK(names.matches(taken));
+                CHECK(seen.insert(taken).second);
+            }
+            CHECK(!consumer.pop(taken));
+        }
+        CHECK(producer.produced() == seen.size());
+        // Nothing is generated with an empty batch.
+        CHECK(producer.fill(0) == 0);
+    }
+    // The object is removed with its producer.
+    CHECK(!namegen::shm_consumer(name).valid());
+
+    // A pattern that was never compiled stops the producer at once.
+    namegen::pattern empty;
+    namegen::shm_producer producer(name, empty, 1, 256, 31);
+    CHECK(producer.valid());
+    CHECK(producer.fill(16, 1000000) == 0);
+    CHECK(producer.status() == namegen::INVALID);
+    return TEST_RESULT();
+}
@@ -0,0 +1,31 @@
+/// @file static_pattern.cpp
+/// @brief Checks that the patterns parsed at compile time draw the same
+/// numbers as the single-pass generator, and give the same names.
+
+#include "namegen/static_pattern.hpp"
+
+#include "patterns.hpp"
+#include "test.hpp"
+
+/// @brief Checks a pattern parsed at compile time.
+template <namegen::detail::fixed_string Source>
+static void check_pattern()
+{
+    namegen::static_pattern<Source> compiled;
+    for (std::size_t i = 0; i < TEST_SEEDS; ++i) {
+        uint64_t serial_seed = TEST_SEED(i), static_seed = TEST_SEED(i);
+        std::string serial_name, static_name;
+        CHECK(namegen::generate(serial_name, Source.data, serial_seed) == namegen::SUCCESS);
+        CHECK(namegen::generate(static_name, compiled, static_seed) == namegen::SUCCESS);
+        CHECK(static_name == serial_name.c_str());
+        CHECK(static_seed == serial_seed);
+    }
+}
+
+int main(int, char *[])
+{
+#define CHECK_PATTERN(name, source) check_pattern<source>();
+    TEST_PATTERNS(CHECK_PATTERN)
+#undef CHECK_PATTERN
+    return TEST_RESULT();
+}
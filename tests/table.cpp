@@ -0,0 +1,74 @@
+/// @file table.cpp
+/// @brief Checks that weighted token tables select their tokens in proportion
+/// to their weights, and that dictionaries re-weight the built-in ones.
+
+#include "namegen/engine.hpp"
+#include "namegen/match.hpp"
+
+#include "test.hpp"
+
+int main(int, char *[])
+{
+    std::vector<std::string> tokens;
+    tokens.push_back("a");
+    tokens.push_back("b");
+    tokens.push_back("c");
+    std::vector<uint32_t> weights;
+    weights.push_back(3);
+    weights.push_back(1);
+    weights.push_back(0);
+    namegen::token_table table(tokens, weights);
+    CHECK(table.weighted());
+    CHECK(table.probability(0) == 0.75);
+    CHECK(table.probability(2) == 0.);
+
+    // The frequencies follow the weights, and a null weight is never drawn.
+    std::size_t counts[3] = { 0, 0, 0 };
+    uint64_t seed         = 1;
+    for (std::size_t i = 0; i < 40000; ++i) {
+        std::size_t index = table.select(seed);
+        CHECK(index < 3);
+        ++counts[index < 3 ? index : 2];
+    }
+    CHECK((counts[0] > 29000) && (counts[0] < 31000));
+    CHECK(counts[2] == 0);
+
+    // Equal weights draw like the built-in tables.
+    namegen::token_table uniform(tokens, std::vector<uint32_t>(3, 2));
+    CHECK(!uniform.weighted());
+    uint64_t uniform_seed = 7, builtin_seed = 7;
+    for (std::size_t i = 0; i < 64; ++i) {
+        CHECK(uniform.select(uniform_seed) == namegen::detail::get_rand<std::size_t>(builtin_seed, 0UL, 3));
+    }
+
+    // Copies own their tokens once changed.
+    namegen::token_table copy = table;
+    CHECK(copy.set_weight("c", 4));
+    CHECK(!copy.set_weight("d", 4));
+    copy.insert("d");
+    CHECK(copy.size() == 4);
+    CHECK(table.size() == 3);
+    CHECK(table.probability(2) == 0.);
+    CHECK(copy.probability(2) == 4. / 9.);
+
+    // A dictionary re-weights a built-in table, and adds new keys.
+    namegen::dictionary tables;
+    namegen::token_table vowels('v');
+    CHECK(vowels.size() > 1);
+    for (std::size_t i = 1; i < vowels.size(); ++i) {
+        CHECK(vowels.set_weight(vowels.token(i), 0));
+    }
+    CHECK(tables.insert('v', vowels));
+    CHECK(tables.insert('x', table));
+    CHECK(!tables.insert('<', table));
+    namegen::pattern compiled;
+    CHECK(namegen::compile(compiled, "vxv", tables) == namegen::SUCCESS);
+    std::string vowel(vowels.token(0));
+    for (std::size_t i = 0; i < 256; ++i) {
+        std::string name;
+        CHECK(namegen::generate(name, compiled, seed) == namegen::SUCCESS);
+        CHECK((name == vowel + "a" + vowel) || (name == vowel + "b" + vowel));
+        CHECK(namegen::matches(compiled, name));
+    }
+    return TEST_RESULT();
+}
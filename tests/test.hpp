@@ -0,0 +1,24 @@
+/// @file test.hpp
+/// @brief Minimal checks shared by the tests.
+/// @details
+/// Every test is a plain executable which reports each failed check on the
+/// standard error, and exits with a non-zero code if any of them failed.
+
+#pragma once
+
+#include <cstdio>
+
+/// Number of failed checks.
+static int failures = 0;
+
+/// Checks a condition, reporting it if it does not hold.
+#define CHECK(condition)                                                                \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                                 \
+        }                                                                               \
+    } while (0)
+
+/// Exit code of a test, from the failed checks.
+#define TEST_RESULT() (failures ? 1 : 0)
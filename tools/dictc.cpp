@@ -0,0 +1,132 @@
+/// @file dictc.cpp
+/// @brief Compiles text token lists into a binary dictionary file.
+/// @details
+/// Usage: namegen-dictc -o output.dict input.txt [input.txt ...]
+///
+/// Every input is a list of tables. A table starts with a line holding its
+/// key, or its name after a dollar sign, between square brackets, followed by
+/// one token per line, optionally followed by its weight:
+///
+///     # Elven prefixes.
+///     [$elf_prefix]
+///     gal 5
+///     cel
+///     ely 2
+///
+///     [x]
+///     ka
+///     lo
+///
+/// Empty lines and lines starting with # are ignored.
+
+#include "namegen/binary.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+/// @brief Binds the table that has just been read to its key or name.
+/// @param tables the dictionary.
+/// @param path the path of the text file.
+/// @param section the key, or the name after a dollar sign.
+/// @param tokens the tokens of the table, they are cleared.
+/// @param weights the weights of the tokens, they are cleared.
+/// @return false if the key or the name is not valid.
+static bool close_table(
+    namegen::dictionary &tables,
+    const std::string &path,
+    std::string &section,
+    std::vector<std::string> &tokens,
+    std::vector<uint32_t> &weights)
+{
+    bool bound = true;
+    if (!section.empty()) {
+        namegen::token_table table(tokens, weights);
+        if (section[0] == '$') {
+            bound = tables.insert(section.substr(1), table);
+        } else {
+            bound = (section.size() == 1) && tables.insert(static_cast<unsigned char>(section[0]), table);
+        }
+        if (!bound) {
+            std::cerr << path << ": invalid table key or name '" << section << "'\n";
+        }
+    }
+    section.clear();
+    tokens.clear();
+    weights.clear();
+    return bound;
+}
+
+/// @brief Adds the tables of a text file to the dictionary.
+/// @param tables the dictionary.
+/// @param path the path of the text file.
+/// @return false if the file cannot be read or contains errors.
+static bool parse(namegen::dictionary &tables, const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cerr << path << ": cannot open the file\n";
+        return false;
+    }
+    std::string line, section;
+    std::vector<std::string> tokens;
+    std::vector<uint32_t> weights;
+    bool valid = true;
+    for (std::size_t number = 1; std::getline(file, line); ++number) {
+        std::istringstream fields(line);
+        std::string token, weight, extra;
+        if (!(fields >> token) || (token[0] == '#')) {
+            continue;
+        }
+        if ((token.size() > 2) && (token[0] == '[') && (token[token.size() - 1] == ']')) {
+            valid   = close_table(tables, path, section, tokens, weights) && valid;
+            section = token.substr(1, token.size() - 2);
+            continue;
+        }
+        char *end       = NULL;
+        unsigned long w = 1;
+        if (fields >> weight) {
+            w = std::strtoul(weight.c_str(), &end, 10);
+        }
+        if (section.empty() || (end && (*end || (w > 0xffffffffUL))) || (fields >> extra)) {
+            std::cerr << path << ":" << number << ": invalid line '" << line << "'\n";
+            valid = false;
+            continue;
+        }
+        tokens.push_back(token);
+        weights.push_back(static_cast<uint32_t>(w));
+    }
+    return close_table(tables, path, section, tokens, weights) && valid;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if ((argument == "-o") && (i + 1 < argc)) {
+            output = argv[++i];
+        } else {
+            inputs.push_back(argument);
+        }
+    }
+    if (output.empty() || inputs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " -o output.dict input.txt [input.txt ...]\n";
+        return 1;
+    }
+    namegen::dictionary tables;
+    bool valid = true;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        valid = parse(tables, inputs[i]) && valid;
+    }
+    if (!valid) {
+        return 1;
+    }
+    if (!namegen::save(tables, output)) {
+        std::cerr << output << ": cannot write the file\n";
+        return 1;
+    }
+    std::cout << output << ": " << tables.keys().size() << " keys, " << tables.names().size() << " names\n";
+    return 0;
+}
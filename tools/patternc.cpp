@@ -0,0 +1,347 @@
+/// @file patternc.cpp
+/// @brief Compiles patterns into C++14 functions, at build time.
+/// @details
+/// Usage: namegen-patternc -o output.hpp [-n namespace] input.txt [input.txt ...]
+///
+/// Every input holds one pattern per line, after the name of the function
+/// that generates it and an equal sign:
+///
+///     # Elves.
+///     elf    = !BVC(ith)
+///     orc    = !<B|C>v(g|k)<s|>
+///
+/// Empty lines and lines starting with # are ignored, and the spaces around
+/// the pattern are not part of it.
+///
+/// Every pattern becomes straight-line code: one branch per alternative, the
+/// thresholds of the reservoir sampling as constants, and the token tables it
+/// uses stored inside the header. Each function writes into a buffer of
+/// bounded size, given by a constant, without allocating:
+///
+///     char name[patterns::elf_max_length + 1];
+///     std::size_t length = patterns::elf(name, seed);
+///
+/// and gives the same names, drawing the same numbers, as the single-pass
+/// generate() with the same pattern and seed.
+
+#include "namegen/pattern.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+/// @brief A pattern to compile.
+struct entry {
+    /// The name of the function.
+    std::string name;
+    /// The pattern.
+    std::string source;
+    /// The compiled pattern.
+    namegen::pattern compiled;
+};
+
+/// @brief Returns a character as a C++ character literal.
+static std::string quote(unsigned char c)
+{
+    std::ostringstream result;
+    if ((c >= 0x20) && (c < 0x7f) && (c != '\\') && (c != '\'')) {
+        result << '\'' << c << '\'';
+    } else {
+        result << "static_cast<char>(" << static_cast<unsigned>(c) << ")";
+    }
+    return result.str();
+}
+
+/// @brief Returns a string as a C++ string literal, for comments too.
+static std::string quote(const std::string &s)
+{
+    std::ostringstream result;
+    result << '"';
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if ((c >= 0x20) && (c < 0x7f) && (c != '\\') && (c != '"')) {
+            result << c;
+        } else {
+            // Octal escapes have at most three digits, unlike hexadecimal ones.
+            result << '\\' << static_cast<char>('0' + ((c >> 6) & 7)) << static_cast<char>('0' + ((c >> 3) & 7))
+                   << static_cast<char>('0' + (c & 7));
+        }
+    }
+    result << '"';
+    return result.str();
+}
+
+/// @brief Returns true if the string is a valid C++ identifier.
+static bool is_identifier(const std::string &s)
+{
+    if (s.empty() || std::isdigit(static_cast<unsigned char>(s[0]))) {
+        return false;
+    }
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (!std::isalnum(static_cast<unsigned char>(s[i])) && (s[i] != '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Writes the code of a group.
+/// @param out the output.
+/// @param compiled the compiled pattern.
+/// @param index the index of the group.
+/// @param indent the indentation of the code.
+/// @param counter numbers the variables of the groups.
+static void write_group(std::ostream &out, const namegen::pattern &compiled, std::size_t index, const std::string &indent, std::size_t &counter);
+
+/// @brief Writes the code of an alternative.
+static void write_alternative(std::ostream &out, const namegen::pattern &compiled, std::size_t index, const std::string &indent, std::size_t &counter)
+{
+    const namegen::pattern::alternative &alternative = compiled.alternatives[index];
+    for (std::size_t i = alternative.first; i < alternative.last; ++i) {
+        const namegen::pattern::item &item = compiled.items[i];
+        if (item.kind == namegen::pattern::ITEM_TOKEN) {
+            int key = static_cast<int>(item.value);
+            out << indent << "{\n"
+                << indent << "    const std::size_t t = static_cast<std::size_t>(namegen::detail::get_rand(seed) % " << item.table->size()
+                << "U);\n"
+                << indent << "    n += detail::emit(buffer + n, detail::tokens_" << key << "() + detail::offsets_" << key << "()[t], detail::lengths_"
+                << key << "()[t], capitalize);\n"
+                << indent << "}\n"
+                << indent << "capitalize = false;\n";
+        } else if (item.kind == namegen::pattern::ITEM_LITERAL) {
+            unsigned char upper = static_cast<unsigned char>(namegen::detail::get_capitalized(item.value, true));
+            if (upper == item.value) {
+                out << indent << "buffer[n++] = " << quote(item.value) << ";\n";
+            } else {
+                out << indent << "buffer[n++] = capitalize ? " << quote(upper) << " : " << quote(item.value) << ";\n";
+            }
+            out << indent << "capitalize = false;\n";
+        } else if (item.kind == namegen::pattern::ITEM_CAPITALIZE) {
+            out << indent << "capitalize = true;\n";
+        } else {
+            write_group(out, compiled, item.group, indent, counter);
+        }
+    }
+}
+
+static void write_group(std::ostream &out, const namegen::pattern &compiled, std::size_t index, const std::string &indent, std::size_t &counter)
+{
+    const namegen::pattern::group &group = compiled.groups[index];
+    if (group.last - group.first == 1) {
+        write_alternative(out, compiled, group.first, indent, counter);
+        return;
+    }
+    // Alternatives weighing nothing never replace the selection.
+    uint64_t total = compiled.alternatives[group.first].weight;
+    bool switches  = false;
+    for (std::size_t i = group.first + 1; i < group.last; ++i) {
+        total += compiled.alternatives[i].weight;
+        switches |= namegen::detail::get_threshold(compiled.alternatives[i].weight, total) != 0;
+    }
+    std::size_t id = counter++;
+    out << indent << "// Group " << id << ".\n";
+    if (switches) {
+        out << indent << "const std::size_t reset_" << id << " = n;\n"
+            << indent << "const bool entry_" << id << " = capitalize;\n";
+    }
+    write_alternative(out, compiled, group.first, indent, counter);
+    total = compiled.alternatives[group.first].weight;
+    for (std::size_t i = group.first + 1; i < group.last; ++i) {
+        const namegen::pattern::alternative &alternative = compiled.alternatives[i];
+        total += alternative.weight;
+        uint64_t threshold = namegen::detail::get_threshold(alternative.weight, total);
+        std::string skip   = (alternative.effect == namegen::pattern::EFFECT_SET)   ? "capitalize = true;\n"
+                             : (alternative.effect == namegen::pattern::EFFECT_CLEAR) ? "capitalize = false;\n"
+                                                                                      : "";
+        if (threshold == 0) {
+            // Never switches, but still draws.
+            out << indent << "namegen::detail::get_rand(seed);\n";
+            if (!skip.empty()) {
+                out << indent << skip;
+            }
+            continue;
+        }
+        out << indent << "if (namegen::detail::get_rand(seed) < " << threshold << "ULL) {\n"
+            << indent << "    n = reset_" << id << ";\n"
+            << indent << "    capitalize = entry_" << id << ";\n";
+        write_alternative(out, compiled, i, indent + "    ", counter);
+        out << indent << "}";
+        if (!skip.empty()) {
+            out << " else {\n"
+                << indent << "    " << skip << indent << "}";
+        }
+        out << "\n";
+    }
+}
+
+/// @brief Reads the patterns of a file.
+/// @param entries the patterns.
+/// @param path the path of the file.
+/// @return false if the file cannot be read or contains errors.
+static bool parse(std::vector<entry> &entries, const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cerr << path << ": cannot open the file\n";
+        return false;
+    }
+    std::string line;
+    bool valid = true;
+    for (std::size_t number = 1; std::getline(file, line); ++number) {
+        std::size_t begin = line.find_first_not_of(" \t\r");
+        if ((begin == std::string::npos) || (line[begin] == '#')) {
+            continue;
+        }
+        std::size_t equal = line.find('=');
+        std::size_t end   = line.find_last_not_of(" \t\r");
+        entry current;
+        if (equal != std::string::npos) {
+            std::size_t last  = line.find_last_not_of(" \t", equal ? equal - 1 : 0);
+            std::size_t first = line.find_first_not_of(" \t", equal + 1);
+            current.name      = (last != std::string::npos && last >= begin) ? line.substr(begin, last - begin + 1) : "";
+            current.source    = (first != std::string::npos && first <= end) ? line.substr(first, end - first + 1) : "";
+        }
+        if ((equal == std::string::npos) || !is_identifier(current.name)) {
+            std::cerr << path << ":" << number << ": invalid line '" << line << "'\n";
+            valid = false;
+            continue;
+        }
+        namegen::return_code_t ret = namegen::compile(current.compiled, current.source);
+        if (ret != namegen::SUCCESS) {
+            std::cerr << path << ":" << number << ": invalid pattern '" << current.source << "' (" << ret << ")\n";
+            valid = false;
+            continue;
+        }
+        entries.push_back(current);
+    }
+    return valid;
+}
+
+/// @brief Writes the header.
+/// @param out the output.
+/// @param entries the patterns.
+/// @param space the namespace of the functions.
+static void write(std::ostream &out, const std::vector<entry> &entries, const std::string &space)
+{
+    // The tables used by the patterns.
+    std::map<int, const namegen::token_table *> tables;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const std::vector<namegen::pattern::item> &items = entries[i].compiled.items;
+        for (std::size_t j = 0; j < items.size(); ++j) {
+            if (items[j].kind == namegen::pattern::ITEM_TOKEN) {
+                tables[items[j].value] = items[j].table;
+            }
+        }
+    }
+    out << "/// @file\n"
+        << "/// @brief Generated by namegen-patternc, do not edit.\n\n"
+        << "#pragma once\n\n"
+        << "#include \"namegen/namegen.hpp\"\n\n"
+        << "#include <cstring>\n\n"
+        << "namespace " << space << "\n{\n\n"
+        << "/// @brief Contains support functions.\n"
+        << "namespace detail\n{\n\n"
+        << "/// @brief Copies a token, capitalizing its first character if requested.\n"
+        << "inline std::size_t emit(char *out, const char *token, std::size_t length, bool capitalize)\n"
+        << "{\n"
+        << "    std::memcpy(out, token, length);\n"
+        << "    if (capitalize) {\n"
+        << "        namegen::detail::capitalize_token(out, length);\n"
+        << "    }\n"
+        << "    return length;\n"
+        << "}\n";
+    for (std::map<int, const namegen::token_table *>::const_iterator it = tables.begin(); it != tables.end(); ++it) {
+        const namegen::token_table &table = *it->second;
+        std::string pool;
+        std::ostringstream offsets, lengths;
+        for (std::size_t i = 0; i < table.size(); ++i) {
+            offsets << (i ? ", " : "") << pool.size();
+            lengths << (i ? ", " : "") << table.length(i);
+            pool.append(table.token(i), table.length(i));
+        }
+        // Local statics of inline functions are shared by all the translation
+        // units, unlike constants at namespace scope.
+        out << "\n/// @brief Returns the tokens of " << quote(static_cast<unsigned char>(it->first)) << ", back to back.\n"
+            << "inline const char *tokens_" << it->first << "()\n{\n"
+            << "    static constexpr char tokens[] = " << quote(pool) << ";\n"
+            << "    return tokens;\n}\n\n"
+            << "/// @brief Returns where each token of " << quote(static_cast<unsigned char>(it->first)) << " starts.\n"
+            << "inline const std::uint32_t *offsets_" << it->first << "()\n{\n"
+            << "    static constexpr std::uint32_t offsets[] = { " << offsets.str() << " };\n"
+            << "    return offsets;\n}\n\n"
+            << "/// @brief Returns the length of each token of " << quote(static_cast<unsigned char>(it->first)) << ".\n"
+            << "inline const std::uint32_t *lengths_" << it->first << "()\n{\n"
+            << "    static constexpr std::uint32_t lengths[] = { " << lengths.str() << " };\n"
+            << "    return lengths;\n}\n";
+    }
+    out << "\n} // namespace detail\n";
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const entry &current = entries[i];
+        std::size_t counter  = 0;
+        out << "\n/// Maximum length of the names of " << quote(current.source) << ".\n"
+            << "constexpr std::size_t " << current.name << "_max_length = " << namegen::detail::get_max_length(current.compiled, 0) << ";\n\n"
+            << "/// @brief Generates a name of the pattern " << quote(current.source) << ".\n"
+            << "/// @param buffer receives the name and a zero, it must hold " << current.name << "_max_length + 1 characters.\n"
+            << "/// @param seed the seed used for random number generation.\n"
+            << "/// @return the length of the name.\n"
+            << "inline std::size_t " << current.name << "(char *buffer, uint64_t &seed)\n"
+            << "{\n"
+            << "    std::size_t n = 0;\n"
+            << "    bool capitalize = false;\n";
+        write_group(out, current.compiled, 0, "    ", counter);
+        out << "    buffer[n] = 0;\n"
+            << "    (void)seed;\n"
+            << "    (void)capitalize;\n"
+            << "    return n;\n"
+            << "}\n\n"
+            << "/// @brief Generates a name of the pattern " << quote(current.source) << ".\n"
+            << "/// @param buffer the string where the name is placed.\n"
+            << "/// @param seed the seed used for random number generation.\n"
+            << "inline void " << current.name << "(std::string &buffer, uint64_t &seed)\n"
+            << "{\n"
+            << "    char name[" << current.name << "_max_length + 1];\n"
+            << "    buffer.assign(name, " << current.name << "(name, seed));\n"
+            << "}\n";
+    }
+    out << "\n} // namespace " << space << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output, space = "patterns";
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if ((argument == "-o") && (i + 1 < argc)) {
+            output = argv[++i];
+        } else if ((argument == "-n") && (i + 1 < argc)) {
+            space = argv[++i];
+        } else {
+            inputs.push_back(argument);
+        }
+    }
+    if (output.empty() || inputs.empty() || !is_identifier(space)) {
+        std::cerr << "Usage: " << argv[0] << " -o output.hpp [-n namespace] input.txt [input.txt ...]\n";
+        return 1;
+    }
+    std::vector<entry> entries;
+    bool valid = true;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        valid = parse(entries, inputs[i]) && valid;
+    }
+    if (!valid) {
+        return 1;
+    }
+    std::ostringstream code;
+    write(code, entries, space);
+    std::ofstream file(output.c_str());
+    if (!(file << code.str()) || !file.flush()) {
+        std::cerr << output << ": cannot write the file\n";
+        return 1;
+    }
+    std::cout << output << ": " << entries.size() << " patterns\n";
+    return 0;
+}